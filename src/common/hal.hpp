@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+/// Thin hardware abstraction for the code meant to run also on the host
+/// (`native` & `simulation` environments): the time. On the Arduino targets
+/// it just forwards to the framework; on the host the time is real (monotonic
+/// clock) or virtual (with `HAL_VIRTUAL_TIME`, advanced by the host program).
+/// The radio is not here: the shared link code takes it as template parameter
+/// (`RF24`, or `SimRF24` in the simulation, with the same names). Pins & the
+/// display aren't here either: the UI (pages, widgets) is for the target only.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+namespace hal
+{
+	inline uint32_t millis() { return ::millis(); }
+	inline uint32_t micros() { return ::micros(); }
+}
+
+#else // host
+#include <chrono>
+
+namespace hal
+{
+#ifdef HAL_VIRTUAL_TIME
+	inline uint64_t virtualNanos = 0;
+
+	inline uint64_t nanos() { return virtualNanos; }
+	inline void advance(uint64_t ns) { virtualNanos += ns; }
+#else
+	inline uint64_t nanos()
+	{
+		static const auto start = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+#endif
+
+	inline uint32_t millis() { return nanos() / 1'000'000; }
+	inline uint32_t micros() { return nanos() / 1'000; }
+}
+
+#endif
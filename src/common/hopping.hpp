@@ -0,0 +1,229 @@
+#pragma once
+#include <stdint.h>
+#include "packets.hpp"
+
+/// Frequency hopping: both sides go through the same pseudo-random sequence
+/// of RF channels, derived from the bind seed, hopping once per control frame.
+/// Hop index is the control frame sequence number, so single received frame
+/// is enough for the receiver to know where the transmitter is.
+
+#ifndef LINK_FHSS
+#define LINK_FHSS 0
+#endif
+#ifndef LINK_BIND_SEED
+#define LINK_BIND_SEED 0x2C3A91F7
+#endif
+#ifndef LINK_CHANNEL
+#define LINK_CHANNEL 76 // RF channel (2400 + n MHz) used without the hopping (RF24 default)
+#endif
+
+constexpr uint8_t hopChannelsCount = 1 << controlSequenceBits;
+constexpr uint8_t hopChannelMin = 2;  // 2402 MHz
+constexpr uint8_t hopChannelMax = 81; // 2481 MHz, staying within the band also on the edges
+constexpr uint8_t hopMinDistance = 8; // MHz, between consecutive hops, to leave single wide interferer quickly
+constexpr uint8_t hopAvoidedHalfWidth = 11; // MHz each side of avoided band center, so a Wi-Fi channel is left out
+
+/// Link channel choice (see `TransmitterRequest::LinkChannel`): 0 for the default,
+/// RF channel without the hopping, or center of the avoided band within the hopping band.
+constexpr bool isLinkChannelValid(uint8_t linkChannel)
+{
+#if LINK_FHSS
+	return linkChannel == 0 || (hopChannelMin <= linkChannel && linkChannel <= hopChannelMax);
+#else
+	return linkChannel <= 125;
+#endif
+}
+
+/// RF channel of the link without the hopping, for given link channel choice
+/// (see `TransmitterRequest::LinkChannel`, 0 is the default).
+constexpr uint8_t fixedLinkChannel(uint8_t linkChannel)
+{
+	return linkChannel ? linkChannel : LINK_CHANNEL;
+}
+
+struct HopSequence
+{
+	uint8_t channels[hopChannelsCount] = {};
+
+	constexpr uint8_t operator[](uint8_t index) const
+	{
+		return channels[index & (hopChannelsCount - 1)];
+	}
+};
+
+constexpr uint8_t hopDistance(uint8_t a, uint8_t b)
+{
+	return a > b ? a - b : b - a;
+}
+
+constexpr bool isHopAvoided(uint8_t channel, uint8_t avoided)
+{
+	return avoided && hopDistance(channel, avoided) <= hopAvoidedHalfWidth;
+}
+
+/// Generates the sequence: shuffled band, taking for each hop the first
+/// channel (in the shuffled order) not used yet and far enough from the
+/// previous one (the last one also from the first, as the sequence wraps).
+/// Should the greedy choice get stuck, the band is shuffled again. Channels
+/// around `avoided` (if not 0) are left out; should that make no sequence
+/// possible, the whole band is used.
+constexpr HopSequence makeHopSequence(uint32_t seed, uint8_t avoided = 0)
+{
+	constexpr uint8_t bandWidth = hopChannelMax - hopChannelMin + 1;
+	constexpr uint8_t attemptsCount = 16;
+	uint8_t candidates[bandWidth] = {};
+	uint8_t candidatesCount = 0;
+	for (uint8_t channel = hopChannelMin; channel <= hopChannelMax; channel++) {
+		if (!isHopAvoided(channel, avoided)) {
+			candidates[candidatesCount++] = channel;
+		}
+	}
+
+	HopSequence sequence;
+	uint32_t state = seed ? seed : 1;
+	for (uint8_t attempt = 0; attempt < attemptsCount; attempt++) {
+		// Fisher-Yates shuffle, with xorshift32 generator
+		for (uint8_t i = candidatesCount - 1; i > 0; i--) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			const uint8_t j = state % (i + 1);
+			const uint8_t t = candidates[i];
+			candidates[i] = candidates[j];
+			candidates[j] = t;
+		}
+
+		bool used[bandWidth] = {};
+		uint8_t count = 0;
+		for (; count < hopChannelsCount; count++) {
+			bool found = false;
+			for (uint8_t i = 0; i < candidatesCount && !found; i++) {
+				const uint8_t channel = candidates[i];
+				if (used[channel - hopChannelMin])
+					continue;
+				if (count > 0 && hopDistance(channel, sequence.channels[count - 1]) < hopMinDistance)
+					continue;
+				if (count == hopChannelsCount - 1 && hopDistance(channel, sequence.channels[0]) < hopMinDistance)
+					continue;
+				used[channel - hopChannelMin] = true;
+				sequence.channels[count] = channel;
+				found = true;
+			}
+			if (!found)
+				break;
+		}
+		if (count == hopChannelsCount)
+			return sequence;
+	}
+	return avoided ? makeHopSequence(seed) : sequence;
+}
+
+/// Channels are in the band (out of the avoided part), unique, and consecutive
+/// ones (with the wrap from the last to the first) at least `hopMinDistance` apart.
+constexpr bool verifyHopSequence(const HopSequence& sequence, uint8_t avoided = 0)
+{
+	for (uint8_t i = 0; i < hopChannelsCount; i++) {
+		if (sequence.channels[i] < hopChannelMin || hopChannelMax < sequence.channels[i])
+			return false;
+		if (isHopAvoided(sequence.channels[i], avoided))
+			return false;
+		for (uint8_t j = 0; j < i; j++) {
+			if (sequence.channels[i] == sequence.channels[j])
+				return false;
+		}
+		const uint8_t next = sequence.channels[(i + 1) & (hopChannelsCount - 1)];
+		if (hopDistance(sequence.channels[i], next) < hopMinDistance)
+			return false;
+	}
+	return true;
+}
+
+constexpr HopSequence hopSequence = makeHopSequence(LINK_BIND_SEED);
+static_assert(verifyHopSequence(hopSequence));
+
+/// Receiver side of the hopping: stays on the channel of expected frame,
+/// hops after each frame (delayed a bit, so the acknowledgement is sent out
+/// first), following the frame timer blindly if frames are missed. Parks
+/// after too many misses, going through the channels a few frame periods
+/// each, waiting to catch any frame to resynchronize: the transmitter gets
+/// ahead by a few hops per channel, so they meet within `acquisitionFramesMax`,
+/// each sweep on other channel (so jammed ones don't keep it parked).
+/// Each channel carries only its own hop index, so frame with other sequence
+/// number is corrupted (despite the CRC) and is rejected, not to desync the
+/// hopping; except the previous one, taken late (after the timer hopped already).
+/// Tracks per-channel receptions and losses.
+struct HopTracker
+{
+	static constexpr uint32_t hopDelay = 1'000; // us, after the frame arrival
+	static constexpr uint8_t parkAfterMissedCount = 2 * hopChannelsCount;
+	static constexpr uint8_t parkedDwellFrames = 4; // frame periods per channel while parked
+	// Transmitter gets `parkedDwellFrames - 1` hops ahead per channel, with that many
+	// frames (at least) caught by the dwell, so no hop offset is skipped
+	static constexpr uint16_t acquisitionFramesMax = parkedDwellFrames
+		* ((hopChannelsCount + parkedDwellFrames - 2) / (parkedDwellFrames - 1));
+
+	struct ChannelStats
+	{
+		uint16_t receivedCount;
+		uint16_t lostCount;
+	};
+	ChannelStats stats[hopChannelsCount] = {};
+
+	HopSequence hops = hopSequence; // of the active link channel
+	uint8_t index = 0; // hop index (sequence) of the frame expected on current channel
+	uint32_t nextHopTime = 0; // us
+	uint8_t missedCount = 0;
+	bool received = false; // since last hop
+	bool parked = true;
+	uint16_t resyncCount = 0; // frames caught while parked
+
+	inline uint8_t channel() const { return hops[index]; }
+
+	/// Registers received frame. Returns false if it doesn't belong to current
+	/// (or previous) channel, as corrupted sequence number, so it's to be dropped.
+	bool onFrame(uint8_t sequence, uint32_t time)
+	{
+		sequence &= hopChannelsCount - 1;
+		if (((index - sequence) & (hopChannelsCount - 1)) > 1)
+			return false;
+		if (parked) {
+			resyncCount += 1;
+		}
+		stats[sequence].receivedCount += 1;
+		index = sequence;
+		nextHopTime = time + hopDelay;
+		missedCount = 0;
+		received = true;
+		parked = false;
+		return true;
+	}
+
+	/// Returns true if channel should be changed (to `channel()`) now.
+	bool update(uint32_t now, uint32_t framePeriod)
+	{
+		if (static_cast<int32_t>(now - nextHopTime) < 0)
+			return false;
+
+		if (parked) {
+			index = (index + 1) & (hopChannelsCount - 1);
+			nextHopTime = now + framePeriod * parkedDwellFrames;
+			return true;
+		}
+
+		if (!received) {
+			stats[index].lostCount += 1;
+			if (++missedCount >= parkAfterMissedCount) {
+				parked = true;
+				nextHopTime = now + framePeriod * parkedDwellFrames;
+				return false; // stay on current channel
+			}
+		}
+		received = false;
+		index = (index + 1) & (hopChannelsCount - 1);
+		nextHopTime += framePeriod;
+		if (static_cast<int32_t>(now - nextHopTime) >= 0) {
+			nextHopTime = now + framePeriod; // far behind, like after long stall
+		}
+		return true;
+	}
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include "packets.hpp"
+
+/// Link profiles: air data rate and the control frames rate, traded between
+/// range and latency. Both sides must use the same one; the transmitter
+/// announces the change in the control frames (`TransmitterRequest::LinkProfile`
+/// with the profile index in the extra byte), and once the receiver confirms
+/// it (in the status), both switch right after the frame with the last
+/// sequence number (before it wraps). Receiver that lost the link goes through
+/// the profiles, in case it missed the switch.
+struct LinkProfile
+{
+	uint8_t dataRate; // as `rf24_datarate_e`: 0 - 1 Mbps, 1 - 2 Mbps, 2 - 250 kbps
+	uint8_t crcLength; // as `rf24_crclength_e`: 1 - 8 bits, 2 - 16 bits
+	uint8_t retryDelay; // auto-retransmit delay, (n + 1) * 250 us: time to wait for the ACK (with status payload)
+	uint16_t frameRate; // Hz
+
+	static constexpr uint32_t settlingTime = 130; // us, TX/RX switching
+
+	static constexpr uint32_t bitRate(uint8_t dataRate) // kbps
+	{
+		return dataRate == 0 ? 1000 : dataRate == 1 ? 2000 : 250;
+	}
+
+	constexpr uint32_t bitRate() const // kbps
+	{
+		return bitRate(dataRate);
+	}
+
+	constexpr uint32_t framePeriod() const // us
+	{
+		return 1'000'000ul / frameRate;
+	}
+
+	/// Time of single packet on air at given data rate & CRC length (as set on the radio), us.
+	static constexpr uint32_t airTime(uint8_t dataRate, uint8_t crcLength, uint8_t payloadSize)
+	{
+		// Preamble, address, packet control field (9 bits, rounded up) & CRC
+		const uint32_t bits = (1 + 5 + 2 + payloadSize + crcLength) * 8;
+		return bits * 1000 / bitRate(dataRate);
+	}
+
+	/// Time of single packet on air, us.
+	constexpr uint32_t airTime(uint8_t payloadSize) const
+	{
+		return airTime(dataRate, crcLength, payloadSize);
+	}
+
+	/// Time from the write start to the packet received (end of it on air), us.
+	constexpr uint32_t transmitTime(uint8_t payloadSize) const
+	{
+		return settlingTime + airTime(payloadSize);
+	}
+
+	/// Time of the frame exchange: control packet, waiting for the ACK with status.
+	constexpr uint32_t exchangeTime(uint8_t controlSize = controlSignalSize) const
+	{
+		const uint32_t ackWait = (retryDelay + 1) * 250ul;
+		const uint32_t ackTime = transmitTime(statusSignalSize);
+		return transmitTime(controlSize) + (ackWait > ackTime ? ackWait : ackTime);
+	}
+};
+
+constexpr LinkProfile linkProfiles[] = {
+	/* Long range   */ { .dataRate = 2, .crcLength = 2, .retryDelay = 3, .frameRate =  50 },
+	/* Standard     */ { .dataRate = 2, .crcLength = 1, .retryDelay = 3, .frameRate = 100 },
+	/* Fast         */ { .dataRate = 0, .crcLength = 1, .retryDelay = 1, .frameRate = 250 },
+	/* Low latency  */ { .dataRate = 1, .crcLength = 1, .retryDelay = 0, .frameRate = 500 },
+};
+constexpr uint8_t linkProfilesCount = sizeof(linkProfiles) / sizeof(linkProfiles[0]);
+constexpr uint8_t defaultLinkProfile = 1;
+
+// Profile index travels in 4 bits of the status, and the exchange must leave
+// at least half of the frame period for the rest of the work (and retransmission),
+// also with the stamped control frames of the latency mode
+static_assert(linkProfilesCount <= 15);
+constexpr bool verifyLinkProfiles()
+{
+	for (const auto& profile : linkProfiles) {
+		if (profile.retryDelay > 15 || profile.frameRate == 0)
+			return false;
+		if (profile.exchangeTime(latencyControlSignalSize) * 2 > profile.framePeriod())
+			return false;
+		// ACK payload must arrive within the wait, or the transmitter gives up on it
+		if ((profile.retryDelay + 1) * 250ul < profile.transmitTime(statusSignalSize))
+			return false;
+	}
+	return true;
+}
+static_assert(verifyLinkProfiles());
@@ -1,3 +1,4 @@
+#pragma once
 #include <stdint.h>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -31,7 +32,7 @@ typedef AnalogChannelCalibrationData AnalogChannelsCalibration[6];
 #pragma pack(push)
 #pragma pack(1)
 
-constexpr uint8_t staticPayloadSize = 16;
+constexpr uint8_t staticPayloadSize = 20; // maximal, dynamic payloads are used (radio allows up to 32)
 
 enum class PacketType : uint8_t
 {
@@ -40,6 +41,8 @@ enum class PacketType : uint8_t
 	Status  = 3,
 	SetServosCalibration = 4,
 	GetServosCalibration = 5,
+	LatencyControl = 6, // control frame with the stamp, see `LatencyEchoPacket`
+	LatencyEcho = 7,
 };
 
 struct CalibrationPacket
@@ -58,27 +61,92 @@ enum class TransmitterRequest : uint8_t
 	None = 0,
 	Status = 3,
 	AnalogCalibration = 5,
+	LinkProfile = 6, // switch to link profile (index in the extra byte), see `link_profiles.hpp`
+	LinkChannel = 7, // switch to link channel (in the extra byte, 0 for the default): RF channel, or center of band avoided by the hopping, see `hopping.hpp`
 };
 
-struct ControlPacket
+constexpr uint8_t controlChannelsCount = 8;
+constexpr uint8_t controlChannelBits = 11;
+constexpr uint16_t controlChannelOffset = 500; // us, channels are sent as offset from it
+constexpr uint16_t controlChannelMax = controlChannelOffset + (1 << controlChannelBits) - 1; // us
+constexpr uint8_t controlSequenceBits = 5;
+constexpr uint8_t controlSequenceMask = (1 << controlSequenceBits) - 1;
+
+/// Control data in convenient, unpacked form.
+struct ControlFrame
 {
 	// Extra request from the receiver
-	TransmitterRequest request;
+	TransmitterRequest request = TransmitterRequest::None;
+
+	// Frame number, wrapping (only `controlSequenceBits` are sent)
+	uint8_t sequence = 0;
 
 	// Main data
-	uint16_t throttle;
-	uint16_t rudder;
-	uint16_t elevator;
-	uint16_t aileron;
-	uint16_t channel5;
-	uint8_t aux1;
-	uint8_t aux2;
-	uint8_t aux3;
-
-	// Extra data
-	union {
-		AnalogChannel channel; // selection for analog calibration request
-	};
+	uint16_t channels[controlChannelsCount] = {}; // us, indexed as `AnalogChannel` first
+	uint8_t switches = 0; // bit mask, bit 0 for AUX 1 and so on
+
+	// Extra data, like channel selection for analog calibration request
+	uint8_t extra = 0;
+
+	constexpr bool aux(uint8_t i) const { return switches & (1 << i); }
+	constexpr void setAux(uint8_t i, bool on) { switches = on ? (switches | (1 << i)) : (switches & ~(1 << i)); }
+};
+
+/// Control data as sent over the air, bit-packed: 3 bits of request & 5 bits of sequence 
+/// number, switches bit mask, 8 channels by 11 bits (little-endian bit stream) and extra byte.
+struct ControlPacket
+{
+	uint8_t header;
+	uint8_t switches;
+	uint8_t channels[controlChannelsCount * controlChannelBits / 8];
+	uint8_t extra;
+
+	constexpr void pack(const ControlFrame& frame)
+	{
+		header = (static_cast<uint8_t>(frame.request) << controlSequenceBits) | (frame.sequence & controlSequenceMask);
+		switches = frame.switches;
+		extra = frame.extra;
+
+		uint32_t bits = 0;
+		uint8_t bitsCount = 0;
+		uint8_t index = 0;
+		for (uint8_t i = 0; i < controlChannelsCount; i++) {
+			const uint16_t us = frame.channels[i];
+			const uint16_t value = us < controlChannelOffset ? 0
+				: us > controlChannelMax ? controlChannelMax - controlChannelOffset 
+				: us - controlChannelOffset;
+			bits |= static_cast<uint32_t>(value) << bitsCount;
+			bitsCount += controlChannelBits;
+			while (bitsCount >= 8) {
+				channels[index++] = bits & 0xFF;
+				bits >>= 8;
+				bitsCount -= 8;
+			}
+		}
+	}
+
+	constexpr ControlFrame unpack() const
+	{
+		ControlFrame frame;
+		frame.request = static_cast<TransmitterRequest>(header >> controlSequenceBits);
+		frame.sequence = header & controlSequenceMask;
+		frame.switches = switches;
+		frame.extra = extra;
+
+		uint32_t bits = 0;
+		uint8_t bitsCount = 0;
+		uint8_t index = 0;
+		for (uint8_t i = 0; i < controlChannelsCount; i++) {
+			while (bitsCount < controlChannelBits) {
+				bits |= static_cast<uint32_t>(channels[index++]) << bitsCount;
+				bitsCount += 8;
+			}
+			frame.channels[i] = controlChannelOffset + (bits & ((1 << controlChannelBits) - 1));
+			bits >>= controlChannelBits;
+			bitsCount -= controlChannelBits;
+		}
+		return frame;
+	}
 };
 
 struct TransmitterSignal
@@ -86,11 +154,16 @@ struct TransmitterSignal
 	PacketType packetType = PacketType::Control;
 
 	union {
-		ControlPacket controlPacket;
+		struct {
+			ControlPacket controlPacket;
+			uint32_t stamp; // us, transmitter time of sampling the controls (`PacketType::LatencyControl` only)
+		};
 		CalibrationPacket calibrationPacket;
 	};
 };
 static_assert(sizeof(TransmitterSignal) <= staticPayloadSize);
+constexpr uint8_t controlSignalSize = sizeof(PacketType) + sizeof(ControlPacket); // using dynamic payloads
+constexpr uint8_t latencyControlSignalSize = controlSignalSize + sizeof(uint32_t);
 
 ////////////////////////////////////////////////////////////////////////////////
 // Receiver
@@ -103,8 +176,27 @@ struct StatusPacket
 		};
 		uint8_t flags;
 	};
-	uint8_t signalRating;
-	float battery;
+	uint8_t signalRating; // 0-100, see `LinkQuality::rating()`
+	uint16_t battery; // mV
+
+	// Link quality over recent control frames window
+	uint8_t lossPercent;
+	uint8_t longestGap; // frames lost in a row
+	uint16_t jitter; // us, inter-arrival
+
+	uint8_t linkProfile; // active profile index (low 4 bits) & pending one, announced by the transmitter (high 4 bits)
+	uint8_t linkChannel; // pending one, announced by the transmitter
+};
+
+/// Latency measurement: in latency mode the transmitter stamps the control frames
+/// (`PacketType::LatencyControl`), and the receiver echoes the stamp of the frame
+/// taken by the outputs, with the delay from its reception (receiver clock) to
+/// the outputs using it (like next servo frame start).
+struct LatencyEchoPacket
+{
+	uint32_t stamp; // us, as sent by the transmitter
+	uint16_t latchDelay; // us, from the reception to the outputs (saturated)
+	uint8_t sequence; // of the stamped frame
 };
 
 struct ReceiverSignal
@@ -114,9 +206,16 @@ struct ReceiverSignal
 	union {
 		StatusPacket statusPacket;
 		CalibrationPacket calibrationPacket;
+		LatencyEchoPacket latencyEchoPacket;
 	};
 };
 static_assert(sizeof(ReceiverSignal) <= staticPayloadSize);
+constexpr uint8_t statusSignalSize = sizeof(PacketType) + sizeof(StatusPacket); // using dynamic payloads
+constexpr uint8_t latencyEchoSignalSize = sizeof(PacketType) + sizeof(LatencyEchoPacket);
+
+// Receiver preloads fresh status as ACK payload after every N-th control frame,
+// so it comes back with the auto-acknowledgement of the next one.
+constexpr uint8_t statusAckInterval = 4;
 
 ////////////////////////////////////////////////////////////////////////////////
 
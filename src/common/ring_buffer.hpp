@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+/// Fixed-size single-producer single-consumer queue, safe between interrupt
+/// (or other core) and the main code without locking. Capacity must be power
+/// of two, up to 128 elements, so indexes are single bytes (atomic on AVR).
+/// Elements can be filled/consumed in place, avoiding copies of bigger items.
+template <typename T, uint8_t Capacity>
+struct RingBuffer
+{
+	static_assert(Capacity && (Capacity & (Capacity - 1)) == 0 && Capacity <= 128, "Capacity must be power of two, up to 128");
+	static constexpr uint8_t mask = Capacity - 1;
+
+	T items[Capacity];
+	uint8_t head = 0; // next to be written, by producer only
+	uint8_t tail = 0; // next to be read, by consumer only
+
+	inline uint8_t size() const
+	{
+		return static_cast<uint8_t>(__atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE));
+	}
+	inline bool empty() const { return size() == 0; }
+	inline bool full() const { return size() == Capacity; }
+
+	////////////////////////////////////////
+	// Producer side
+
+	/// Returns slot to be filled, or null if full. Not visible for consumer until `commit()`.
+	inline T* acquire()
+	{
+		return full() ? nullptr : &items[head & mask];
+	}
+
+	inline void commit()
+	{
+		__atomic_store_n(&head, static_cast<uint8_t>(head + 1), __ATOMIC_RELEASE);
+	}
+
+	bool push(const T& item)
+	{
+		T* slot = acquire();
+		if (!slot) return false;
+		*slot = item;
+		commit();
+		return true;
+	}
+
+	////////////////////////////////////////
+	// Consumer side
+
+	/// Returns oldest element, or null if empty. Stays in place until `release()`.
+	inline T* peek()
+	{
+		return empty() ? nullptr : &items[tail & mask];
+	}
+
+	inline void release()
+	{
+		__atomic_store_n(&tail, static_cast<uint8_t>(tail + 1), __ATOMIC_RELEASE);
+	}
+
+	bool pop(T& item)
+	{
+		T* slot = peek();
+		if (!slot) return false;
+		item = *slot;
+		release();
+		return true;
+	}
+};
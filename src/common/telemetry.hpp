@@ -0,0 +1,172 @@
+#pragma once
+#include <stdint.h>
+#include "ring_buffer.hpp"
+
+/// Binary telemetry stream, replacing the formatted prints. Each record is:
+///
+///     sync (0xA5) | type | payload length | payload... | CRC-8 (type, length & payload)
+///
+/// All values little-endian. Decoder (`tools/telemetry_decode.py`) skips
+/// anything not matching, so text prints (like startup ones) can be mixed in.
+
+constexpr uint8_t telemetrySync = 0xA5;
+
+enum class TelemetryRecordType : uint8_t
+{
+	Frame = 1,
+	Failsafe = 2,
+	Hop = 3,
+	Output = 4,
+	Latency = 5,
+};
+
+#pragma pack(push)
+#pragma pack(1)
+
+/// State after received control frame.
+struct TelemetryFrameRecord
+{
+	static constexpr TelemetryRecordType type = TelemetryRecordType::Frame;
+
+	uint32_t time; // us, when the frame was received
+	uint8_t sequence;
+	uint8_t switches;
+	uint16_t channels[8]; // us
+	uint8_t signalRating;
+	uint8_t goodSignal : 1; // `testRPD()` at the reception
+	uint8_t linkProfile : 4; // index of active link profile
+	uint8_t _reserved : 3;
+	uint16_t battery; // mV
+	uint16_t droppedCount; // frames lost because of full receive buffer, in total
+};
+static_assert(sizeof(TelemetryFrameRecord) == 28);
+
+/// Failsafe entry or exit.
+struct TelemetryFailsafeRecord
+{
+	static constexpr TelemetryRecordType type = TelemetryRecordType::Failsafe;
+
+	uint32_t time; // us
+	uint8_t entered; // 1 on entry, 0 on exit
+	uint32_t silence; // us since last frame: when noticed (entry) or whole outage (exit)
+	uint16_t latency; // us, noticed after the timeout (entry only)
+	uint16_t entriesCount; // in total
+};
+static_assert(sizeof(TelemetryFailsafeRecord) == 13);
+
+/// Statistics of single hopping channel (sent in turns).
+struct TelemetryHopRecord
+{
+	static constexpr TelemetryRecordType type = TelemetryRecordType::Hop;
+
+	uint8_t index; // in the hop sequence
+	uint8_t channel; // RF channel (2400 + n MHz)
+	uint16_t receivedCount;
+	uint16_t lostCount;
+	uint16_t resyncCount; // in total, not per channel
+};
+static_assert(sizeof(TelemetryHopRecord) == 8);
+
+/// Servo outputs timing, since previous record.
+struct TelemetryOutputRecord
+{
+	static constexpr TelemetryRecordType type = TelemetryRecordType::Output;
+
+	uint32_t time; // us
+	uint16_t edgesCount; // software driven pulse edges
+	uint16_t averageLateness; // 0.5 us units, of the edges after scheduled time
+	uint16_t maxLateness; // 0.5 us units
+	uint16_t latchedCount; // output frames which took new values, in total
+};
+static_assert(sizeof(TelemetryOutputRecord) == 12);
+
+/// Stamped control frame (latency mode) taken by the outputs, as echoed back.
+struct TelemetryLatencyRecord
+{
+	static constexpr TelemetryRecordType type = TelemetryRecordType::Latency;
+
+	uint32_t time; // us, when the frame was received
+	uint32_t stamp; // us, transmitter time of sampling the controls
+	uint16_t latchDelay; // us, from the reception to the outputs
+	uint8_t sequence;
+};
+static_assert(sizeof(TelemetryLatencyRecord) == 11);
+
+#pragma pack(pop)
+
+/// CRC-8 (polynomial 0x07, no reflection, zero init).
+constexpr uint8_t crc8(uint8_t crc, uint8_t byte)
+{
+	crc ^= byte;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+	}
+	return crc;
+}
+
+constexpr uint8_t crc8(const uint8_t* data, uint8_t length, uint8_t crc = 0)
+{
+	for (uint8_t i = 0; i < length; i++) {
+		crc = crc8(crc, data[i]);
+	}
+	return crc;
+}
+
+inline constexpr uint8_t crcCheckInput[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+static_assert(crc8(crcCheckInput, sizeof(crcCheckInput)) == 0xF4); // standard check value
+
+/// Records waiting to be sent, drained as the output has space, without ever
+/// blocking. Whole record is dropped (and counted) if it doesn't fit.
+template <uint8_t Capacity>
+struct TelemetryStream
+{
+	static constexpr uint8_t overhead = 4; // sync, type, length & CRC
+
+	RingBuffer<uint8_t, Capacity> buffer;
+	uint16_t droppedCount = 0;
+	uint8_t decimation = 1; // for regular (per frame) records, 0 to disable them
+	uint8_t decimationCounter = 0;
+
+	/// Returns true if regular record should be written this time.
+	bool tick()
+	{
+		if (decimation == 0)
+			return false;
+		if (++decimationCounter < decimation)
+			return false;
+		decimationCounter = 0;
+		return true;
+	}
+
+	template <typename Record>
+	bool write(const Record& record)
+	{
+		static_assert(sizeof(Record) + overhead <= Capacity);
+		if (static_cast<uint8_t>(Capacity - buffer.size()) < sizeof(Record) + overhead) {
+			droppedCount += 1;
+			return false;
+		}
+		const auto* payload = reinterpret_cast<const uint8_t*>(&record);
+		const uint8_t header[2] = { static_cast<uint8_t>(Record::type), sizeof(Record) };
+		buffer.push(telemetrySync);
+		buffer.push(header[0]);
+		buffer.push(header[1]);
+		for (uint8_t i = 0; i < sizeof(Record); i++) {
+			buffer.push(payload[i]);
+		}
+		buffer.push(crc8(payload, sizeof(Record), crc8(header, 2)));
+		return true;
+	}
+
+	/// Moves as much as the output can take without blocking (like serial port
+	/// with interrupt driven transmit buffer).
+	template <typename Output>
+	void drain(Output& output)
+	{
+		int space = output.availableForWrite();
+		uint8_t byte;
+		while (space-- > 0 && buffer.pop(byte)) {
+			output.write(byte);
+		}
+	}
+};
@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+// Micro-benchmarks of the hot paths, running on the host (`native` environment).
+//
+// Usage:
+//     program [--filter <text>] [--save <file>] [--baseline <file>] [--threshold <percent>] [--mcu-factor <ratio>]
+//
+// Prints nanoseconds per operation (median of few runs). With `--baseline`
+// (file saved earlier with `--save`) prints the change too, and exits with
+// failure if anything got slower more than the threshold (default 10%).
+// Host timings only approximate the MCUs, but relative changes are telling.
+// Per-frame work of the radio task is also checked against the frame budget
+// at the highest rate, scaled by the host to MCU ratio (`--mcu-factor`).
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "common/hal.hpp"
+#include "common/packets.hpp"
+#include "common/hopping.hpp"
+#include "common/telemetry.hpp"
+#include "common/link_profiles.hpp"
+#include "transmitter/calibration.hpp"
+#include "transmitter/mixer.hpp"
+#include "transmitter/timing_stats.hpp"
+#include "receiver/link_quality.hpp"
+#include "receiver/failsafe.hpp"
+
+/// Prevents the compiler from optimizing away the value (or the work to get it).
+template <typename T>
+inline void keep(T const& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark
+{
+	const char* name;
+	std::function<void(uint32_t iteration)> operation;
+	bool frameWork = false; // checked against `frameWorkBudget`
+};
+
+/// Per-frame work (mapping, mixing & packing: Map & Pack stages on the Profile
+/// page) must fit the time the fastest link profile leaves after the radio
+/// exchange (with stamped frames of the latency mode), halved for the rest
+/// of the frame (sampling, publishing, jitter).
+constexpr const LinkProfile& fastestLinkProfile = linkProfiles[linkProfilesCount - 1];
+constexpr uint32_t frameWorkBudget = (fastestLinkProfile.framePeriod()
+	- fastestLinkProfile.exchangeTime(latencyControlSignalSize)) / 2; // us, on the MCU
+
+/// MCU time per host time, for the budget check: ESP32-S3 at 240 MHz (in-order)
+/// against a desktop host, clock & instructions per cycle together. Measured
+/// ratio (Map & Pack averages from the Profile page, divided by 240 cycles/us,
+/// against this benchmark) should be passed with `--mcu-factor`.
+constexpr double defaultMcuFactor = 100;
+constexpr double mcuCyclesPerMicrosecond = 240;
+
+/// Runs operation in batches, growing until the batch takes long enough
+/// for the clock, then takes median of few batches.
+double measure(const Benchmark& benchmark)
+{
+	constexpr uint64_t minBatchDuration = 20'000'000; // ns
+	constexpr uint8_t runsCount = 7;
+
+	uint32_t iterations = 16;
+	while (true) {
+		const uint64_t start = hal::nanos();
+		for (uint32_t i = 0; i < iterations; i++) benchmark.operation(i);
+		if (hal::nanos() - start >= minBatchDuration || iterations >= (1u << 30)) break;
+		iterations *= 2;
+	}
+
+	double results[runsCount];
+	for (auto& result : results) {
+		const uint64_t start = hal::nanos();
+		for (uint32_t i = 0; i < iterations; i++) benchmark.operation(i);
+		result = static_cast<double>(hal::nanos() - start) / iterations;
+	}
+	std::sort(results, results + runsCount);
+	return results[runsCount / 2];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixtures
+
+constexpr AnalogChannelsCalibration calibration = {
+	{ .rawMin =  685, .rawCenter =  685, .rawMax = 1647, .usMin = 1000, .usCenter = 1000, .usMax = 2000 },
+	{ .rawMin =  663, .rawCenter = 1047, .rawMax = 1427, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =  680, .rawCenter = 1090, .rawMax = 1490, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin = 3793, .rawCenter = 3207, .rawMax = 2779, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =    0, .rawCenter = 2048, .rawMax = 4095, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =    0, .rawCenter =    0, .rawMax = 4095, .usMin = 1000, .usCenter = 1000, .usMax = 2000 },
+};
+
+/// Mixer using all the features: elevon, expo & dual rates, trims.
+MixerSettings makeMixerSettings()
+{
+	MixerSettings settings;
+	settings.applyPreset(MixPreset::Elevon);
+	for (uint8_t i = 0; i < mixerCurvedInputsCount; i++) {
+		auto& input = settings.inputs[i];
+		input.expo[0] = 30;
+		input.expo[1] = 50;
+		input.rate[1] = 70;
+		input.rateSwitch = i % 3;
+		input.trim = i * 5 - 10;
+	}
+	return settings;
+}
+
+/// Pseudo-random raw analog values, like noisy sticks.
+uint16_t rawValues[1024][6];
+
+void prepareFixtures()
+{
+	uint32_t state = 12345;
+	for (auto& values : rawValues) {
+		for (auto& value : values) {
+			state = state * 1664525 + 1013904223;
+			value = (state >> 16) & 0xFFF;
+		}
+	}
+}
+
+struct NullOutput
+{
+	int availableForWrite() { return 64; }
+	void write(uint8_t byte) { keep(byte); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+
+std::vector<Benchmark> makeBenchmarks()
+{
+	static CompiledCalibration compiled;
+	compiled.update(calibration);
+	static const MixerSettings mixerSettings = makeMixerSettings();
+	static CompiledMixer mixer;
+	mixer.update(mixerSettings);
+	static ControlPacket packet;
+	static ControlFrame frame;
+	for (uint8_t i = 0; i < controlChannelsCount; i++) frame.channels[i] = 1000 + i * 111;
+	packet.pack(frame);
+	static LinkQuality linkQuality;
+	static Failsafe failsafe;
+	static HopTracker hopTracker;
+	static TelemetryStream<128> telemetry;
+	static NullOutput nullOutput;
+	static TimingStats timingStats;
+
+	return {
+		{ "calibration/reference-map (6 ch)", [](uint32_t i) {
+			const auto& raw = rawValues[i & 1023];
+			uint16_t mapped[6];
+			for (uint8_t c = 0; c < 6; c++) mapped[c] = mapAnalogValue(raw[c], calibration[c]);
+			keep(mapped);
+		}},
+		{ "calibration/lut-map (6 ch)", [](uint32_t i) {
+			uint16_t mapped[6];
+			compiled.map(rawValues[i & 1023], mapped);
+			keep(mapped);
+		}},
+		{ "calibration/compile-table", [](uint32_t i) {
+			static CalibrationTable table;
+			table.compile(calibration[i % 6]);
+			keep(table);
+		}},
+		{ "mixer/lut-map+mix (8 ch)", [](uint32_t i) {
+			uint16_t mapped[6];
+			compiled.map(rawValues[i & 1023], mapped);
+			uint16_t channels[controlChannelsCount];
+			mixer.mix(mapped, i & 0b111, channels);
+			keep(channels);
+		}},
+		{ "mixer/compile-curve", [](uint32_t i) {
+			static MixerCurveTable table;
+			table.compile(i % 101, 100);
+			keep(table);
+		}},
+		{ "mixer/update (unchanged)", [](uint32_t) {
+			keep(mixer.update(mixerSettings));
+		}},
+		{ "frame/map+mix+pack", [](uint32_t i) {
+			uint16_t mapped[6];
+			compiled.map(rawValues[i & 1023], mapped);
+			frame.switches = i & 0b111;
+			mixer.mix(mapped, frame.switches, frame.channels);
+			frame.sequence = i;
+			packet.pack(frame);
+			keep(packet);
+		}, true },
+		{ "packet/pack", [](uint32_t i) {
+			frame.sequence = i;
+			packet.pack(frame);
+			keep(packet);
+		}},
+		{ "packet/unpack", [](uint32_t i) {
+			packet.header = i & controlSequenceMask;
+			const ControlFrame unpacked = packet.unpack();
+			keep(unpacked);
+		}},
+		{ "link-quality/on-frame (2% loss)", [](uint32_t i) {
+			if (i % 50 == 7) return;
+			linkQuality.onFrame(i, i * 10'000 + (i % 3) * 50, true);
+		}},
+		{ "link-quality/report", [](uint32_t) {
+			keep(linkQuality.lossPercent());
+			keep(linkQuality.longestGap());
+			keep(linkQuality.jitter());
+			keep(linkQuality.rating());
+		}},
+		{ "failsafe/check", [](uint32_t i) {
+			keep(failsafe.check(i));
+		}},
+		{ "failsafe/feed", [](uint32_t i) {
+			keep(failsafe.feed(i * 10'000, i));
+		}},
+		{ "hopping/update", [](uint32_t i) {
+			keep(hopTracker.update(i * 1'000, 10'000));
+			if (i % 10 == 0) hopTracker.onFrame(i / 10, i * 1'000);
+		}},
+		{ "hopping/make-sequence", [](uint32_t i) {
+			keep(makeHopSequence(i));
+		}},
+		{ "telemetry/write+drain frame record", [](uint32_t i) {
+			TelemetryFrameRecord record {};
+			record.time = i;
+			telemetry.write(record);
+			telemetry.drain(nullOutput);
+		}},
+		{ "telemetry/crc8 (28 bytes)", [](uint32_t i) {
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(rawValues[i & 1023]);
+			keep(crc8(data, 28));
+		}},
+		{ "timing-stats/add", [](uint32_t i) {
+			timingStats.add(i & 0xFFFF);
+		}},
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+
+std::map<std::string, double> loadResults(const char* path)
+{
+	std::map<std::string, double> results;
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "Cannot open baseline file: %s\n", path);
+		exit(2);
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), file)) {
+		// Format: name<TAB>ns
+		char* tab = strchr(line, '\t');
+		if (!tab) continue;
+		*tab = 0;
+		results[line] = atof(tab + 1);
+	}
+	fclose(file);
+	return results;
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = nullptr;
+	const char* savePath = nullptr;
+	const char* baselinePath = nullptr;
+	double threshold = 10; // %
+	double mcuFactor = defaultMcuFactor;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "--save") && i + 1 < argc) savePath = argv[++i];
+		else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) baselinePath = argv[++i];
+		else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--mcu-factor") && i + 1 < argc) mcuFactor = atof(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [--filter <text>] [--save <file>] [--baseline <file>] [--threshold <percent>] [--mcu-factor <ratio>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	std::map<std::string, double> baseline;
+	if (baselinePath) baseline = loadResults(baselinePath);
+	FILE* save = savePath ? fopen(savePath, "w") : nullptr;
+
+	prepareFixtures();
+	bool regressed = false;
+	bool overBudget = false;
+	printf("%-40s %12s\n", "benchmark", "ns/op");
+	for (const auto& benchmark : makeBenchmarks()) {
+		if (filter && !strstr(benchmark.name, filter))
+			continue;
+		const double ns = measure(benchmark);
+		printf("%-40s %12.2f", benchmark.name, ns);
+		const auto previous = baseline.find(benchmark.name);
+		if (previous != baseline.end() && previous->second > 0) {
+			const double change = 100 * (ns - previous->second) / previous->second;
+			const bool worse = change > threshold;
+			regressed |= worse;
+			printf("  %+7.1f%%%s", change, worse ? "  REGRESSION" : "");
+		}
+		if (benchmark.frameWork) {
+			// Expected on the MCU: time, cycles (as on the Profile page) & share of the frame
+			const double mcu = ns * mcuFactor / 1000; // us
+			const bool over = mcu > frameWorkBudget;
+			overBudget |= over;
+			printf("  MCU ~%.1f us (%.0f cycles), %.1f%% of %lu us frame, budget %lu us%s", mcu, mcu * mcuCyclesPerMicrosecond,
+				100 * mcu / fastestLinkProfile.framePeriod(), static_cast<unsigned long>(fastestLinkProfile.framePeriod()),
+				static_cast<unsigned long>(frameWorkBudget), over ? "  OVER BUDGET" : "");
+		}
+		printf("\n");
+		if (save) fprintf(save, "%s\t%.3f\n", benchmark.name, ns);
+	}
+	if (save) fclose(save);
+	return regressed || overBudget ? 1 : 0;
+}
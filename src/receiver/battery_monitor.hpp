@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+
+/// Receiver battery voltage, from ADC conversions made in background (auto
+/// triggered, taken by the conversion complete interrupt), filtered with
+/// exponential moving average in integer millivolts, so reading it is just
+/// a copy. Conversion to millivolts is multiplication & shift (no division,
+/// no floats), cheap enough for the interrupt.
+struct BatteryMonitor
+{
+	static constexpr uint16_t fullScale = 15'000; // mV at the ADC max: 5 V reference, 1:3 divider
+	static constexpr uint16_t adcMax = 1023;
+	static constexpr uint16_t scale = (fullScale * 1024ul + adcMax / 2) / adcMax; // mV per ADC step, by 1024
+	static constexpr uint8_t averageShift = 6; // over ~64 samples, smoothing the sag under servo load
+
+	uint32_t average = 0; // mV, by 2^averageShift
+	bool primed = false; // first sample taken as it is
+
+	static constexpr uint16_t toMillivolts(uint16_t raw)
+	{
+		return (raw * static_cast<uint32_t>(scale)) >> 10;
+	}
+
+	constexpr void add(uint16_t raw)
+	{
+		const uint32_t mv = toMillivolts(raw);
+		if (!primed) {
+			average = mv << averageShift;
+			primed = true;
+			return;
+		}
+		average = average - (average >> averageShift) + mv;
+	}
+
+	constexpr uint16_t millivolts() const
+	{
+		return (average + (1u << (averageShift - 1))) >> averageShift;
+	}
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+enum class FailsafeMode : uint8_t
+{
+	Hold,   // keep last received position
+	Preset, // go to configured position
+};
+
+struct FailsafeChannelConfig
+{
+	FailsafeMode mode;
+	uint16_t position; // us, for preset mode
+};
+
+/// Link loss watchdog. Frames are fed as they arrive, while periodic timer
+/// interrupt checks whether too many frame periods passed since the last one
+/// (the period is estimated from the arrivals, as transmitter rate can vary).
+/// Check interval bounds the latency of noticing, which is measured too.
+/// Not thread-safe by itself: feeding and reading from the main code should
+/// be done with interrupts disabled.
+struct Failsafe
+{
+	static constexpr uint32_t minTimeout = 3'000; // us
+	static constexpr uint32_t maxFramePeriod = 100'000; // us, longer intervals are outages, not the frame period
+
+	uint8_t missedFramesCount = 10;
+	uint32_t framePeriod = 20'000; // us, estimated (moving average of intervals per frame)
+	bool framePeriodEstimated = false; // until then, the default is used
+	uint32_t timeout = 200'000; // us
+	uint32_t lastFrameTime = 0; // us
+	uint8_t lastSequence = 0;
+
+	bool active = true; // until first frame arrives
+
+	// Events
+	uint16_t entriesCount = 0;
+	uint32_t lastEntryTime = 0; // us
+	uint32_t lastEntrySilence = 0; // us, since last frame, when noticed
+	uint16_t lastEntryLatency = 0; // us, noticed after the timeout
+	uint16_t maxEntryLatency = 0; // us
+	uint16_t exitsCount = 0;
+	uint32_t lastExitTime = 0; // us
+	uint32_t lastExitSilence = 0; // us, whole outage
+
+	/// Checks for timeout, to be called periodically (from timer interrupt).
+	/// Returns true if failsafe was just entered, so outputs should be moved.
+	bool check(uint32_t now)
+	{
+		if (active)
+			return false;
+		const uint32_t silence = now - lastFrameTime;
+		if (silence < timeout)
+			return false;
+		active = true;
+		entriesCount += 1;
+		lastEntryTime = now;
+		lastEntrySilence = silence;
+		const uint32_t latency = silence - timeout;
+		lastEntryLatency = latency < UINT16_MAX ? latency : UINT16_MAX;
+		if (lastEntryLatency > maxEntryLatency) maxEntryLatency = lastEntryLatency;
+		return true;
+	}
+
+	/// Registers arrival of the frame. Returns true if failsafe was just exited
+	/// (not counting the initial state, before any frame).
+	bool feed(uint32_t time, uint8_t sequence)
+	{
+		const uint32_t interval = time - lastFrameTime;
+		const uint8_t advance = (sequence - lastSequence) & controlSequenceMask;
+		lastSequence = sequence;
+		// Interval divided by frames it spans (as losses would inflate it), only if short enough to be sure
+		if (lastFrameTime && 0 < advance && advance <= 4 && interval < maxFramePeriod) {
+			const uint32_t period = interval / advance;
+			if (framePeriodEstimated) {
+				framePeriod += (static_cast<int32_t>(period) - static_cast<int32_t>(framePeriod)) / 8;
+			}
+			else {
+				framePeriod = period;
+				framePeriodEstimated = true;
+			}
+		}
+		lastFrameTime = time;
+		updateTimeout();
+
+		if (!active)
+			return false;
+		active = false;
+		if (entriesCount == 0)
+			return false;
+		exitsCount += 1;
+		lastExitTime = time;
+		lastExitSilence = interval;
+		return true;
+	}
+
+	/// Sets the frame period (like after the link profile change), to be
+	/// estimated again from the arrivals.
+	void setFramePeriod(uint32_t period)
+	{
+		framePeriod = period;
+		framePeriodEstimated = false;
+		updateTimeout();
+	}
+
+	void setMissedFramesCount(uint8_t count)
+	{
+		missedFramesCount = count ? count : 1;
+		updateTimeout();
+	}
+
+private:
+	void updateTimeout()
+	{
+		const uint32_t t = static_cast<uint32_t>(missedFramesCount) * framePeriod;
+		timeout = t < minTimeout ? minTimeout : t;
+	}
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+/// Follows stamped control frame (latency mode) from its reception to the
+/// outputs taking it (latch), making the echo for the transmitter. Only the
+/// first frame given to the outputs since the previous latch is followed:
+/// later ones go out with the same latch, just waiting less, so the echoes
+/// tell the worse case. Main code gives the frames (with interrupts disabled,
+/// along setting the outputs), the output interrupts report the latches.
+struct LatencyProbe
+{
+	static constexpr uint16_t maxLatchDelay = 0xFFFF; // us
+
+	uint32_t stamp = 0; // of followed frame
+	uint32_t receptionTime = 0; // us
+	uint8_t sequence = 0;
+	bool pending = false; // frame given to the outputs, waiting for the latch
+	bool echoReady = false;
+	LatencyEchoPacket echo {};
+	uint32_t echoReceptionTime = 0; // us, of the echoed frame
+
+	constexpr void onOutputs(uint32_t stamp, uint8_t sequence, uint32_t receptionTime)
+	{
+		if (pending)
+			return;
+		this->stamp = stamp;
+		this->sequence = sequence;
+		this->receptionTime = receptionTime;
+		pending = true;
+	}
+
+	/// Outputs took the pending values, effective at given time (us).
+	constexpr void onLatch(uint32_t time)
+	{
+		if (!pending)
+			return;
+		const uint32_t delay = time - receptionTime;
+		echo.stamp = stamp;
+		echo.sequence = sequence;
+		echo.latchDelay = delay < maxLatchDelay ? delay : maxLatchDelay;
+		echoReceptionTime = receptionTime;
+		echoReady = true; // newer one replaces not taken one
+		pending = false;
+	}
+
+	/// Takes the echo of the latest latch (and reception time of its frame), if not taken yet.
+	constexpr bool takeEcho(LatencyEchoPacket& out, uint32_t& receptionTime)
+	{
+		if (!echoReady)
+			return false;
+		out = echo;
+		receptionTime = echoReceptionTime;
+		echoReady = false;
+		return true;
+	}
+};
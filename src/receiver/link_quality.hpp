@@ -0,0 +1,139 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+/// Link quality over sliding window of recent control frames, based on their
+/// sequence numbers: packet loss, longest gap (frames lost in a row), and
+/// inter-arrival jitter (smoothed as in RFC 3550, relative to the estimated
+/// frame period). Also tracks how many of received frames had strong signal
+/// (`testRPD()`). The window moves only as frames arrive; ongoing outage
+/// is the failsafe concern.
+struct LinkQuality
+{
+	static constexpr uint8_t windowSize = 128; // frames
+	static constexpr uint8_t sequenceModulo = controlSequenceMask + 1;
+
+	uint8_t receivedBits[windowSize / 8] = {};
+	uint8_t strongBits[windowSize / 8] = {};
+	uint8_t head = 0; // slot of the newest frame
+	uint8_t filled = 0; // slots in use, until the window fills up
+	uint8_t receivedCount = 0;
+	uint8_t strongCount = 0;
+
+	bool started = false;
+	uint8_t lastSequence = 0;
+	uint32_t lastTime = 0; // us
+	uint32_t framePeriod = 0; // us, estimated from consecutive frames
+	uint32_t jitterState = 0; // us, Q4 fixed point
+
+	constexpr void onFrame(uint8_t sequence, uint32_t time, bool strongSignal)
+	{
+		sequence &= controlSequenceMask;
+		uint16_t advance = 1;
+		if (started) {
+			advance = (sequence - lastSequence) & controlSequenceMask;
+			if (advance == 0)
+				return; // duplicate, like retransmitted after lost ACK
+			const uint32_t interval = time - lastTime;
+
+			// Sequence wraps quickly, so longer outages are resolved using the time
+			if (framePeriod) {
+				const uint32_t estimated = (interval + framePeriod / 2) / framePeriod;
+				if (estimated > static_cast<uint32_t>(advance) + sequenceModulo / 2) {
+					advance += (estimated - advance + sequenceModulo / 2) / sequenceModulo * sequenceModulo;
+				}
+			}
+
+			if (advance == 1) {
+				framePeriod = framePeriod ? framePeriod + (static_cast<int32_t>(interval) - static_cast<int32_t>(framePeriod)) / 8 : interval;
+			}
+			if (framePeriod && advance <= 4) {
+				const int32_t deviation = static_cast<int32_t>(interval) - static_cast<int32_t>(advance * framePeriod);
+				const uint32_t d = deviation < 0 ? -deviation : deviation;
+				jitterState += static_cast<int32_t>((d << 4) - jitterState) / 16;
+			}
+		}
+		started = true;
+		lastSequence = sequence;
+		lastTime = time;
+
+		if (advance > windowSize) advance = windowSize;
+		for (uint16_t i = 1; i <= advance; i++) {
+			push(i == advance, strongSignal);
+		}
+	}
+
+	/// Percent of frames lost in the window.
+	constexpr uint8_t lossPercent() const
+	{
+		return filled ? 100 - (100u * receivedCount + filled / 2) / filled : 0;
+	}
+
+	/// Percent of received frames with strong signal.
+	constexpr uint8_t strongPercent() const
+	{
+		return receivedCount ? (100u * strongCount + receivedCount / 2) / receivedCount : 0;
+	}
+
+	/// Most frames lost in a row, within the window.
+	constexpr uint8_t longestGap() const
+	{
+		uint8_t longest = 0;
+		uint8_t current = 0;
+		for (uint8_t i = 0; i < filled; i++) {
+			const uint8_t slot = (head - i) & (windowSize - 1);
+			if (bit(receivedBits, slot)) {
+				current = 0;
+			}
+			else if (++current > longest) {
+				longest = current;
+			}
+		}
+		return longest;
+	}
+
+	/// Inter-arrival jitter, us.
+	constexpr uint16_t jitter() const
+	{
+		const uint32_t j = (jitterState + 8) >> 4;
+		return j < UINT16_MAX ? j : UINT16_MAX;
+	}
+
+	/// Single 0-100 figure for quick judgement: received frames, with lost
+	/// ones in a row counting more (as long gaps matter more than sparse losses).
+	constexpr uint8_t rating() const
+	{
+		const uint8_t loss = lossPercent();
+		const uint8_t gapPenalty = longestGap() > 10 ? 10 : longestGap();
+		return loss + gapPenalty >= 100 ? 0 : 100 - loss - gapPenalty;
+	}
+
+private:
+	static constexpr bool bit(const uint8_t* bits, uint8_t slot)
+	{
+		return bits[slot >> 3] & (1 << (slot & 7));
+	}
+
+	static constexpr void setBit(uint8_t* bits, uint8_t slot, bool value)
+	{
+		if (value) bits[slot >> 3] |= (1 << (slot & 7));
+		else bits[slot >> 3] &= ~(1 << (slot & 7));
+	}
+
+	constexpr void push(bool received, bool strong)
+	{
+		head = (head + 1) & (windowSize - 1);
+		if (filled == windowSize) {
+			// Oldest slot gets overwritten
+			receivedCount -= bit(receivedBits, head);
+			strongCount -= bit(strongBits, head);
+		}
+		else {
+			filled += 1;
+		}
+		setBit(receivedBits, head, received);
+		setBit(strongBits, head, received && strong);
+		receivedCount += received;
+		strongCount += received && strong;
+	}
+};
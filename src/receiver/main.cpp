@@ -1,16 +1,32 @@
 #include <SPI.h>
 #include <nRF24L01.h>
 #include <RF24.h>
-#include <Servo.h>
-#include "common/packets.hpp"
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "receiver_link.hpp"
+#include "sbus.hpp"
+#include "ppm.hpp"
+#include "servo_outputs.hpp"
+
+// Output modes, selected by `RECEIVER_OUTPUT`
+#define OUTPUT_PWM  0 // servos, each on own pin (6 channels), see `ServoOutputs`
+#define OUTPUT_SBUS 1 // SBUS frames on the serial TX pin (8 channels used, needs inverter), no telemetry then
+#define OUTPUT_PPM  2 // PPM sum stream on `PPM_OUTPUT_PIN` (8 channels)
+#ifndef RECEIVER_OUTPUT
+#define RECEIVER_OUTPUT OUTPUT_PWM
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // Hardware
 
-RF24 radio(7, 8);
+#define RADIO_CE_PIN 7
+#define RADIO_CSN_PIN 8
+
+RF24 radio(RADIO_CE_PIN, RADIO_CSN_PIN);
 
 const uint8_t transmitterOutputAddress[6] = "ctrl!";
-const uint8_t transmitterInputAddress[6]  = "info?";
+
+#define RADIO_IRQ_PIN A0 // active low; pin change interrupt, as D2 & D3 are taken by servos
 
 #define RECEIVER_BATTERY_PIN A7
 
@@ -19,83 +35,121 @@ const uint8_t transmitterInputAddress[6]  = "info?";
 #define SERVO_CH3_PIN 4
 #define SERVO_CH4_PIN 5
 #define SERVO_CH5_PIN 6
-#define SERVO_CH6_PIN 9
+#define SERVO_CH6_PIN 9 // OC1A (Timer1 compare output), so driven by the hardware
+
+#define PPM_OUTPUT_PIN 9 // OC1A (Timer1 compare output), instead of the servo 6
+
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+constexpr uint8_t servosCount = ServoOutputs::count;
+constexpr uint8_t softwareServosCount = servosCount - 1; // last one uses the compare output
+const uint8_t servoPins[servosCount] = { SERVO_CH1_PIN, SERVO_CH2_PIN, SERVO_CH3_PIN, SERVO_CH4_PIN, SERVO_CH5_PIN, SERVO_CH6_PIN };
+volatile uint8_t* servoPorts[softwareServosCount]; // output registers, for quick edges
+uint8_t servoMasks[softwareServosCount];
+ServoOutputs servoOutputs;
+uint8_t servoSlot = 0; // software driven servo to start with next edge
+EdgeLateness servoEdgeLateness;
+unsigned long lastOutputReportTime = 0;
+constexpr uint16_t outputReportInterval = 1000; // ms
+constexpr uint8_t outputsCount = servosCount;
+#else
+constexpr uint8_t outputsCount = controlChannelsCount;
+volatile uint16_t outputChannels[outputsCount]; // us, taken by the output interrupts
+bool outputsChanged = false; // since last SBUS frame packing
+#endif
 
-Servo ch1, ch2, ch3, ch4, ch5, ch6;
+#if RECEIVER_OUTPUT == OUTPUT_SBUS
+SbusFrame sbusFrames[2]; // double buffered: interrupt sends the front one, main code packs the other
+volatile uint8_t sbusFrontIndex = 0;
+volatile bool sbusFrontStamped = false; // front frame carries followed latency frame, not sent yet
+uint8_t sbusTicks = 0; // of the watchdog timer, since last SBUS frame
+constexpr uint8_t sbusFramePeriod = 14; // ms
+#elif RECEIVER_OUTPUT == OUTPUT_PPM
+PpmEncoder ppmEncoder;
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // State
 
-struct SignalStabilityCounter
+constexpr uint8_t defaultTelemetryDecimation = 5; // every 5th frame, keeping 115200 baud busy only partially at 500 Hz
+
+/// Keeps the radio interrupt from using the SPI while main code talks to the radio.
+/// Pin changes meanwhile are still flagged, so the interrupt runs right after.
+struct RadioLock
 {
-	static constexpr uint16_t updateInterval = 500;
-	static constexpr uint16_t averageCountForInterval = 200;
+	RadioLock() { *digitalPinToPCICR(RADIO_IRQ_PIN) &= ~_BV(digitalPinToPCICRbit(RADIO_IRQ_PIN)); }
+	~RadioLock() { *digitalPinToPCICR(RADIO_IRQ_PIN) |= _BV(digitalPinToPCICRbit(RADIO_IRQ_PIN)); }
+};
 
-	unsigned long lastUpdateTime = 0;
-	
-	unsigned long timeSinceLastTxSignalSums = 0;
-	
-	uint16_t goodCount = 0;
-	uint16_t weakCount = 0;
+void setRadioProfile(const LinkProfile& profile)
+{
+	radio.setDataRate(static_cast<rf24_datarate_e>(profile.dataRate));
+	radio.setCRCLength(static_cast<rf24_crclength_e>(profile.crcLength));
+}
+static_assert(RF24_1MBPS == 0 && RF24_2MBPS == 1 && RF24_250KBPS == 2);
+static_assert(RF24_CRC_8 == 1 && RF24_CRC_16 == 2);
 
-	uint8_t lastRating = 0;
+/// Outputs & radio of this board, for the link (see `ReceiverLink`).
+struct Board
+{
+	static constexpr uint8_t outputsCount = ::outputsCount;
 
-	inline void probe()
+	/// Holds off the interrupts, restoring the previous state after (as `ATOMIC_RESTORESTATE`).
+	struct InterruptLock
 	{
-		if (radio.testRPD()) {
-			goodCount += 1;
+		const uint8_t sreg = SREG;
+		InterruptLock() { cli(); }
+		~InterruptLock() { __asm__ volatile ("" ::: "memory"); SREG = sreg; }
+	};
+
+	void setOutputs(const ControlFrame& frame)
+	{
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+		for (uint8_t i = 0; i < servosCount; i++) {
+			// Channel 6 is AUX 1 as 2-position channel
+			servoOutputs.set(i, frame.channels[i]);
 		}
-		else {
-			weakCount += 1;
+#else
+		for (uint8_t i = 0; i < outputsCount; i++) {
+			outputChannels[i] = constrain(frame.channels[i], 700, 2300);
 		}
+		outputsChanged = true;
+#endif
 	}
 
-	inline void update()
+	void setFailsafeOutput(uint8_t index, uint16_t us)
 	{
-		if (lastUpdateTime + updateInterval < millis()) {
-			lastUpdateTime = millis();
-			
-			if (goodCount == 0 && weakCount == 0) {
-				// No signal
-				lastRating = 0;
-			}
-			else {
-				lastRating = (
-					constrain(33 * (goodCount + weakCount) / averageCountForInterval, 0, 33) +
-					33 * (goodCount) / (goodCount + weakCount)
-				);
-
-#if DEBUG_SIGNAL_STABILITY
-				printf(
-					"signalStability::update()\t"
-					"count: %3d\t"
-					"count/average ratio: %3d%%\t"
-					"good/weak ratio: %3d%%\t"
-					"average delta time: %3lu\t"
-					"--> RATING: %3u\tfail? %u\n",
-					(goodCount + weakCount),
-					100 * (goodCount + weakCount) / averageCountForInterval,
-					100 * (goodCount) / (goodCount + weakCount),
-					timeSinceLastTxSignalSums / (goodCount + weakCount),
-					lastRating,
-					radio.failureDetected
-				);
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+		servoOutputs.set(index, us);
+#else
+		outputChannels[index] = us;
 #endif
+	}
 
-				timeSinceLastTxSignalSums = 0;
-				goodCount = 0;
-				weakCount = 0;
-			}
-		}
+	void setChannel(uint8_t channel)
+	{
+		RadioLock lock;
+		// Leave RX mode for the change, so the synthesizer relocks on new channel
+		digitalWrite(RADIO_CE_PIN, LOW);
+		radio.setChannel(channel);
+		digitalWrite(RADIO_CE_PIN, HIGH);
 	}
-};
-SignalStabilityCounter signalStability;
 
-TransmitterSignal txSignal;
-ReceiverSignal rxSignal;
+	void setRadioProfile(const LinkProfile& profile)
+	{
+		RadioLock lock;
+		digitalWrite(RADIO_CE_PIN, LOW);
+		::setRadioProfile(profile);
+		digitalWrite(RADIO_CE_PIN, HIGH);
+	}
 
-unsigned long lastTxSignalTime = 0;
-unsigned long lastRxSignalTime = 0;
+	void writeAckPayload(const ReceiverSignal& signal, uint8_t size)
+	{
+		RadioLock lock;
+		radio.writeAckPayload(1, &signal, size);
+	}
+};
+Board board;
+ReceiverLink<Board> link(board);
 
 ////////////////////////////////////////////////////////////////////////////////
 // Setup
@@ -105,32 +159,281 @@ int serial_putc(char c, FILE *) { Serial.write(c); return c; }
 void setup()
 {
 	// Initialize the serial port
+#if RECEIVER_OUTPUT == OUTPUT_SBUS
+	Serial.begin(100'000, SERIAL_8E2); // taken by the SBUS, so no telemetry
+	link.telemetry.decimation = 0;
+#else
 	Serial.begin(115200);
 	Serial.println(F("Setup!"));
 	fdevopen(&serial_putc, 0);
+	link.telemetry.decimation = defaultTelemetryDecimation;
+#endif
 
 	// Set pin modes
 	pinMode(RECEIVER_BATTERY_PIN, INPUT);
 
-	// Initialize servos
-	ch1.attach(SERVO_CH1_PIN);
-	ch2.attach(SERVO_CH2_PIN);
-	ch3.attach(SERVO_CH3_PIN);
-	ch4.attach(SERVO_CH4_PIN);
-	ch5.attach(SERVO_CH5_PIN);
-	ch6.attach(SERVO_CH6_PIN);
+	// Initialize outputs, in failsafe positions until first frame
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+	for (uint8_t i = 0; i < servosCount; i++) {
+		servoOutputs.set(i, failsafeChannels[i].mode == FailsafeMode::Preset ? failsafeChannels[i].position : 1500);
+		digitalWrite(servoPins[i], LOW);
+		pinMode(servoPins[i], OUTPUT);
+	}
+	for (uint8_t i = 0; i < softwareServosCount; i++) {
+		servoPorts[i] = portOutputRegister(digitalPinToPort(servoPins[i]));
+		servoMasks[i] = digitalPinToBitMask(servoPins[i]);
+	}
+	servoOutputs.latch();
+
+	// Servos: Timer1 in CTC mode with TOP in ICR1 (mode 12), 16 MHz / 8 = 0.5 us ticks, 20 ms frames.
+	// Compare A drives the last servo pin directly (set at the frame start, cleared after the pulse),
+	// compare B interrupts make the edges of the others, one pulse after another.
+	TCCR1A = _BV(COM1A1) | _BV(COM1A0); // set on compare match, at the frame start
+	TCCR1B = _BV(WGM13) | _BV(WGM12) | _BV(CS11);
+	ICR1 = ServoOutputs::framePeriod * 2 - 1;
+	OCR1A = 0;
+	OCR1B = 0;
+	TIMSK1 = _BV(OCIE1A) | _BV(OCIE1B);
+#else
+	for (uint8_t i = 0; i < outputsCount; i++) {
+		outputChannels[i] = failsafeChannels[i].mode == FailsafeMode::Preset ? failsafeChannels[i].position : 1500;
+	}
+#endif
+#if RECEIVER_OUTPUT == OUTPUT_PPM
+	// PPM: Timer1 in fast PWM mode with TOP in ICR1 (mode 14), 16 MHz / 8 = 0.5 us ticks.
+	// OC1A goes high at each slot start and low after the pulse; the compare
+	// interrupt sets the slot length then (so first slot starts with the maximal one).
+	pinMode(PPM_OUTPUT_PIN, OUTPUT);
+	TCCR1A = _BV(COM1A1) | _BV(WGM11);
+	TCCR1B = _BV(WGM13) | _BV(WGM12) | _BV(CS11);
+	OCR1A = PpmEncoder::pulseWidth * 2 - 1;
+	ICR1 = PpmEncoder::maxChannel * 2 - 1;
+	TIMSK1 = _BV(OCIE1A);
+#endif
+
+	// Battery: ADC conversions auto triggered by Timer0 overflow (~1 kHz, already running
+	// for `millis`), AVcc reference, 125 kHz ADC clock; results taken by the interrupt
+	ADMUX = _BV(REFS0) | ((RECEIVER_BATTERY_PIN - A0) & 0x07);
+	ADCSRB = _BV(ADTS2);
+	ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+	// Failsafe watchdog: Timer2 in CTC mode, 16 MHz / 128 / 125 = 1 kHz
+	TCCR2A = _BV(WGM21);
+	TCCR2B = _BV(CS22) | _BV(CS20);
+	OCR2A = 124;
+	TIMSK2 = _BV(OCIE2A);
 
 	// Initialize radio and start listening to allow read
 	radio.begin();  
-	radio.setDataRate(RF24_250KBPS);
 	radio.setPALevel(RF24_PA_MAX);
-	radio.setAutoAck(false);
-	radio.setRetries(0, 0);
-	radio.setPayloadSize(staticPayloadSize);
-	radio.setCRCLength(RF24_CRC_8);
+	radio.setAutoAck(true);
+	radio.enableDynamicPayloads();
+	radio.enableAckPayload(); // status goes back with the acknowledgements
 	radio.openReadingPipe(1, transmitterOutputAddress);
-	radio.openWritingPipe(transmitterInputAddress);
-	radio.startListening();
+	radio.maskIRQ(/*tx_ok*/ true, /*tx_fail*/ true, /*rx_ready*/ false);
+	radio.startListening(); // also flushes the ACK payloads
+
+	// Radio interrupt
+	pinMode(RADIO_IRQ_PIN, INPUT);
+	*digitalPinToPCMSK(RADIO_IRQ_PIN) |= _BV(digitalPinToPCMSKbit(RADIO_IRQ_PIN));
+	*digitalPinToPCICR(RADIO_IRQ_PIN) |= _BV(digitalPinToPCICRbit(RADIO_IRQ_PIN));
+	link.begin(); // profile & channel, first status
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Radio interrupt
+
+/// Reads all received payloads into the buffer, timestamped. Other interrupts
+/// (servos, timers) are allowed to run meanwhile, as the SPI transfers take
+/// a while; only this one is held off.
+ISR(PCINT1_vect)
+{
+	const unsigned long time = micros();
+	if (digitalRead(RADIO_IRQ_PIN) == HIGH)
+		return; // released, after flags were cleared
+
+	*digitalPinToPCICR(RADIO_IRQ_PIN) &= ~_BV(digitalPinToPCICRbit(RADIO_IRQ_PIN));
+	interrupts();
+
+	// Each read clears the RX_DR flag, so the IRQ is released once FIFO is drained
+	link.receive(radio, time);
+
+	noInterrupts();
+	*digitalPinToPCICR(RADIO_IRQ_PIN) |= _BV(digitalPinToPCICRbit(RADIO_IRQ_PIN));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Battery
+
+/// Conversion complete: feeds the average, next one starts with next trigger.
+ISR(ADC_vect)
+{
+	link.batteryMonitor.add(ADC);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Failsafe
+
+/// Watchdog tick (1 kHz), moving the outputs to failsafe positions once
+/// the frames stop arriving. Noticed within 1 ms after the timeout.
+/// Also sends the SBUS frames, at fixed intervals.
+ISR(TIMER2_COMPA_vect)
+{
+#if RECEIVER_OUTPUT == OUTPUT_SBUS
+	if (++sbusTicks >= sbusFramePeriod) {
+		sbusTicks = 0;
+		const SbusFrame& frame = sbusFrames[sbusFrontIndex];
+		Serial.write(frame.bytes, sizeof(frame.bytes)); // fits the serial buffer, sent in background
+		if (sbusFrontStamped) {
+			sbusFrontStamped = false;
+			link.latencyProbe.onLatch(micros());
+		}
+	}
+#endif
+
+	link.checkFailsafe();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Outputs
+
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+/// Hardware driven servo: pin was set at the frame start, so schedule clearing
+/// it after the pulse; or it was cleared, so schedule setting at next frame start.
+ISR(TIMER1_COMPA_vect)
+{
+	if (OCR1A == 0) {
+		TCCR1A = _BV(COM1A1); // clear on compare match
+		OCR1A = servoOutputs.active[servosCount - 1] * 2;
+	}
+	else {
+		TCCR1A = _BV(COM1A1) | _BV(COM1A0); // set on compare match
+		OCR1A = 0;
+	}
+}
+
+/// Software driven servos: ends the pulse of previous one, starts the next
+/// one right away (or, after the last one, takes new widths for next frame).
+ISR(TIMER1_COMPB_vect)
+{
+	servoEdgeLateness.add(TCNT1 - OCR1B);
+	if (servoSlot > 0) {
+		*servoPorts[servoSlot - 1] &= ~servoMasks[servoSlot - 1];
+	}
+	if (servoSlot < softwareServosCount) {
+		*servoPorts[servoSlot] |= servoMasks[servoSlot];
+		OCR1B += servoOutputs.active[servoSlot] * 2;
+		servoSlot += 1;
+	}
+	else {
+		if (servoOutputs.changed) {
+			// New widths go out from the next frame start
+			link.latencyProbe.onLatch(micros() + (ICR1 - TCNT1 + 1) / 2);
+		}
+		servoOutputs.latch(); // between the frames, so all channels change together
+		OCR1B = 0;
+		servoSlot = 0;
+	}
+}
+
+/// Reports the servo edges timing, periodically.
+void reportOutputs()
+{
+	if (millis() - lastOutputReportTime < outputReportInterval)
+		return;
+	lastOutputReportTime = millis();
+	TelemetryOutputRecord record;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		record.edgesCount = servoEdgeLateness.edgesCount;
+		record.averageLateness = servoEdgeLateness.edgesCount ? servoEdgeLateness.sum / servoEdgeLateness.edgesCount : 0;
+		record.maxLateness = servoEdgeLateness.max;
+		record.latchedCount = servoOutputs.latchedCount;
+		servoEdgeLateness = EdgeLateness();
+	}
+	record.time = micros();
+	link.telemetry.write(record);
+}
+#elif RECEIVER_OUTPUT == OUTPUT_SBUS
+/// Packs new SBUS frame if the outputs or failsafe state changed, then makes
+/// it the one sent by the interrupt.
+void updateSbus()
+{
+	static bool packedFailsafe = false;
+	uint16_t channels[outputsCount];
+	bool failsafeActive;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		failsafeActive = link.failsafe.active;
+		for (uint8_t i = 0; i < outputsCount; i++) channels[i] = outputChannels[i];
+	}
+	if (!outputsChanged && failsafeActive == packedFailsafe && sbusFrames[sbusFrontIndex].bytes[0])
+		return;
+	outputsChanged = false;
+	packedFailsafe = failsafeActive;
+	const uint8_t back = sbusFrontIndex ^ 1;
+	sbusFrames[back].pack(channels, outputsCount, failsafeActive ? SbusFrame::frameLost | SbusFrame::failsafe : 0);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		sbusFrontIndex = back;
+		sbusFrontStamped = link.latencyProbe.pending; // its values were taken above
+	}
+}
+#elif RECEIVER_OUTPUT == OUTPUT_PPM
+/// Pulse ended: sets length of current slot (well before its end, as the slots
+/// are longer than the pulse). Edges are made by the timer itself.
+ISR(TIMER1_COMPA_vect)
+{
+	if (ppmEncoder.slot == 0) {
+		link.latencyProbe.onLatch(micros()); // taken for the frame starting now
+	}
+	ICR1 = ppmEncoder.next(outputChannels) * 2 - 1;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Misc
+
+/// Handles simple text commands from the serial port, line by line:
+/// + `d<N>` - telemetry decimation: frame record every N-th frame, 0 disables.
+/// + `m<N>` - failsafe timeout, in missed frames.
+void handleSerialCommands()
+{
+	static char command = 0;
+	static uint16_t argument = 0;
+	while (Serial.available()) {
+		const char c = Serial.read();
+		if (c == '\n' || c == '\r') {
+			if (command == 'd') {
+				link.telemetry.decimation = argument < 255 ? argument : 255;
+			}
+			else if (command == 'm') {
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+					link.failsafe.setMissedFramesCount(argument < 255 ? argument : 255);
+				}
+			}
+			command = 0;
+			argument = 0;
+		}
+		else if (!command) {
+			command = c;
+		}
+		else if ('0' <= c && c <= '9') {
+			argument = argument * 10 + (c - '0');
+		}
+	}
+}
+
+/// Sleeps until next interrupt (radio, timers, serial), unless there is
+/// something received already.
+void idle()
+{
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	noInterrupts();
+	if (link.receivedSignals.empty()) {
+		sleep_enable();
+		interrupts(); // takes effect after next instruction, so no wake-up is lost
+		sleep_cpu();
+		sleep_disable();
+	}
+	interrupts();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -138,82 +441,21 @@ void setup()
 
 void loop()
 {
-	// Update signal stability counters
-	signalStability.update();
-	
-	// Receive transmitter signal
-	if (radio.available()) {
-		unsigned long timeSinceLastTxSignal = millis() - lastTxSignalTime;
-		lastTxSignalTime = millis();
-
-		radio.read(&txSignal, sizeof(txSignal));
-		
-		signalStability.probe();
-		signalStability.timeSinceLastTxSignalSums += timeSinceLastTxSignal;
-
-		if (txSignal.packetType == PacketType::Control) {
-			if (txSignal.controlPacket.request == TransmitterRequest::Status) {
-				txSignal.controlPacket.request = TransmitterRequest::None; // to avoid retransmission
-				radio.stopListening();
-				rxSignal.packetType = PacketType::Status;
-				rxSignal.statusPacket.battery = (5.f * analogRead(RECEIVER_BATTERY_PIN) / 1023) * 3;
-				rxSignal.statusPacket.signalRating = signalStability.lastRating;
-				rxSignal.statusPacket.goodSignal = 50 < 
-					(100 * (signalStability.goodCount) / (signalStability.goodCount + signalStability.weakCount));
-				radio.write(&rxSignal, sizeof(rxSignal));
-				radio.startListening();
-				lastRxSignalTime = millis();
-				printf(
-					"time=%lu\t"
-					"Sent StatusPacket!\t"
-					"battery=%.2f\t"
-					"signalRating=%u\t"
-					"goodSignal=%u\t"
-					"\n",
-					lastRxSignalTime,
-					rxSignal.statusPacket.battery, // TODO: prints '?', most likely printf here has no floating support
-					rxSignal.statusPacket.signalRating,
-					rxSignal.statusPacket.goodSignal
-				);
-			}
+	link.update();
 
-			// For now just print it all out
-			printf(
-				"time=%lu\t"
-				"signalRating=%u\t"
-				"testRPD=%u\t"
-				"timeSinceLastTxSignal=%lu\t"
-				"throttle=%hu\t"
-				"rudder=%hu\t"
-				"elevator=%hu\t"
-				"aileron=%hu\t"
-				"channel5=%hu\t"
-				"aux1=%u\t"
-				"aux2=%u\t"
-				"aux3=%u\t"
-				"battery=%u\n",
-				millis(), 
-				signalStability.lastRating,
-				radio.testRPD(),
-				timeSinceLastTxSignal,
-				txSignal.controlPacket.throttle,
-				txSignal.controlPacket.rudder,
-				txSignal.controlPacket.elevator,
-				txSignal.controlPacket.aileron,
-				txSignal.controlPacket.channel5,
-				txSignal.controlPacket.aux1,
-				txSignal.controlPacket.aux2,
-				txSignal.controlPacket.aux3,
-				analogRead(RECEIVER_BATTERY_PIN)
-			);
-
-			// Update servos
-			ch1.writeMicroseconds(constrain(txSignal.controlPacket.throttle, 700, 2300));
-			ch2.writeMicroseconds(constrain(txSignal.controlPacket.rudder,   700, 2300));
-			ch3.writeMicroseconds(constrain(txSignal.controlPacket.elevator, 700, 2300));
-			ch4.writeMicroseconds(constrain(txSignal.controlPacket.aileron,  700, 2300));
-			ch5.writeMicroseconds(constrain(txSignal.controlPacket.channel5, 700, 2300));
-			ch6.writeMicroseconds(txSignal.controlPacket.aux1 ? 1000 : 2000);
-		}
+	// Telemetry & commands
+#if RECEIVER_OUTPUT == OUTPUT_SBUS
+	updateSbus();
+#else
+#if RECEIVER_OUTPUT == OUTPUT_PWM
+	reportOutputs();
+#endif
+	link.telemetry.drain(Serial);
+	handleSerialCommands();
+#endif
+
+	// Receive transmitter signal
+	if (!link.handleSignal()) {
+		idle();
 	}
 }
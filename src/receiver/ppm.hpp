@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+/// PPM sum stream: channels as intervals between short pulses, followed by
+/// long sync gap filling the frame up to fixed length. Hardware timer makes
+/// the pulses (so their edges don't depend on the interrupts latency); this
+/// gives it the length of each slot (pulse & the gap after it). Channels are
+/// latched together at the frame start, so they change within the same frame.
+struct PpmEncoder
+{
+	static constexpr uint8_t channelsCount = 8;
+	static constexpr uint16_t pulseWidth = 300; // us
+	static constexpr uint16_t frameLength = 22'500; // us
+	static constexpr uint16_t minChannel = 700; // us
+	static constexpr uint16_t maxChannel = 2300; // us
+	static constexpr uint16_t minSyncLength = frameLength - channelsCount * maxChannel; // us
+	static_assert(minSyncLength >= 4'000, "sync must stay distinguishable from the channels");
+
+	uint16_t latched[channelsCount] = {};
+	uint8_t slot = 0; // next one, `channelsCount` for the sync
+	uint16_t frameUsed = 0; // us, by the channels so far
+
+	/// Returns length of the next slot (us). Takes the channels (us) at the frame start.
+	template <typename Channels>
+	constexpr uint16_t next(const Channels& channels)
+	{
+		if (slot == channelsCount) {
+			const uint16_t length = frameLength - frameUsed;
+			slot = 0;
+			frameUsed = 0;
+			return length;
+		}
+		if (slot == 0) {
+			for (uint8_t i = 0; i < channelsCount; i++) {
+				const uint16_t us = channels[i];
+				latched[i] = us < minChannel ? minChannel : us > maxChannel ? maxChannel : us;
+			}
+		}
+		const uint16_t length = latched[slot++];
+		frameUsed += length;
+		return length;
+	}
+};
@@ -0,0 +1,408 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include "common/hal.hpp"
+#include "common/packets.hpp"
+#include "common/ring_buffer.hpp"
+#include "common/telemetry.hpp"
+#include "common/hopping.hpp"
+#include "common/link_profiles.hpp"
+#include "failsafe.hpp"
+#include "link_quality.hpp"
+#include "latency_probe.hpp"
+#include "battery_monitor.hpp"
+
+/// Transmitter signal as received by the radio interrupt.
+struct ReceivedSignal
+{
+	uint32_t time; // us, when the IRQ fired
+	bool goodSignal; // `testRPD()` right after the reception
+	TransmitterSignal signal;
+};
+
+const FailsafeChannelConfig failsafeChannels[controlChannelsCount] = {
+	{ FailsafeMode::Preset, 1000 }, // throttle: minimum
+	{ FailsafeMode::Preset, 1500 }, // rudder: centered
+	{ FailsafeMode::Preset, 1500 }, // elevator: centered
+	{ FailsafeMode::Preset, 1500 }, // aileron: centered
+	{ FailsafeMode::Hold, 0 },      // channel 5
+	{ FailsafeMode::Hold, 0 },      // AUX 1
+	{ FailsafeMode::Hold, 0 },      // AUX 2
+	{ FailsafeMode::Hold, 0 },      // AUX 3
+};
+
+#if LINK_FHSS
+/// Longest time of catching the hopping transmitter while parked, over the link profiles (us).
+constexpr uint32_t hopAcquisitionTimeMax()
+{
+	uint32_t longest = 0;
+	for (const auto& profile : linkProfiles) {
+		const uint32_t time = HopTracker::acquisitionFramesMax * profile.framePeriod();
+		if (time > longest) longest = time;
+	}
+	return longest;
+}
+#endif
+
+/// Receiver side of the link: takes the control frames (link quality, failsafe,
+/// hopping, outputs), answers with the status & latency echoes in the ACK
+/// payloads, switches the link profiles & channels and keeps the link going
+/// (hopping, link scan, failsafe watchdog), writing the telemetry. Shared by the firmware
+/// and the link simulation, so both run the same code. Time comes from `hal`,
+/// the rest of the platform from `Board`:
+/// + `outputsCount` - count of the outputs, up to `controlChannelsCount`,
+/// + `InterruptLock` - scope type holding off the interrupts (which share the state),
+/// + `setOutputs(frame)` - takes the channels of received frame, with the interrupts held off,
+/// + `setFailsafeOutput(index, us)` - from the watchdog interrupt,
+/// + `setChannel(channel)`, `setRadioProfile(profile)`, `writeAckPayload(signal, size)` -
+///   radio access from the main code (so out of the way of the radio interrupt).
+template <typename Board>
+struct ReceiverLink
+{
+	static constexpr uint16_t linkScanDelay = 1000; // ms without frames, before going through the profiles
+	static constexpr uint16_t linkScanDwell = 900; // ms per profile, covering the parked hopping acquisition at the slowest rate
+	static constexpr uint16_t hopReportInterval = 100; // ms, per channel, so all are reported in ~3 seconds
+#if LINK_FHSS
+	static_assert(linkScanDwell * 1000ul >= hopAcquisitionTimeMax());
+#endif
+
+	Board& board;
+
+	RingBuffer<ReceivedSignal, 4> receivedSignals; // filled by the radio interrupt
+	volatile uint16_t droppedSignalsCount = 0; // received while the buffer was full
+	LinkQuality linkQuality;
+	Failsafe failsafe; // shared with the watchdog interrupt
+	LatencyProbe latencyProbe; // shared with the output interrupts
+	BatteryMonitor batteryMonitor; // fed by the ADC interrupt
+	TelemetryStream<128> telemetry;
+#if LINK_FHSS
+	HopTracker hopTracker;
+#endif
+
+	uint8_t linkProfile = defaultLinkProfile; // active, index in `linkProfiles`
+	uint8_t pendingLinkProfile = defaultLinkProfile; // announced by the transmitter
+	uint8_t linkChannel = 0; // active, see `TransmitterRequest::LinkChannel`
+	uint8_t pendingLinkChannel = 0; // announced by the transmitter
+
+	ReceiverSignal rxSignal;
+	uint8_t framesSinceStatus = 0;
+	bool echoQueued = false; // as last ACK payload, so the status goes next
+	uint16_t batteryVoltage = 0; // mV, updated along the status
+	uint16_t reportedFailsafeEntriesCount = 0;
+	uint32_t lastLinkScanTime = 0; // ms
+#if LINK_FHSS
+	uint8_t reportedHopIndex = 0;
+	uint32_t lastHopReportTime = 0; // ms
+#endif
+
+	explicit ReceiverLink(Board& board) : board(board) {}
+
+	/// Sets the radio for the link (once it's listening) & queues first status.
+	void begin()
+	{
+		board.setRadioProfile(linkProfiles[linkProfile]);
+#if LINK_FHSS
+		board.setChannel(hopTracker.channel());
+#else
+		board.setChannel(fixedLinkChannel(linkChannel));
+#endif
+		{
+			typename Board::InterruptLock lock;
+			failsafe.setFramePeriod(linkProfiles[linkProfile].framePeriod());
+		}
+		queueStatus();
+	}
+
+	/// Radio interrupt: reads all received payloads into the buffer, with
+	/// the time of the interrupt.
+	template <typename Radio>
+	void receive(Radio& radio, uint32_t time)
+	{
+		while (radio.available()) {
+			const uint8_t size = radio.getDynamicPayloadSize();
+			ReceivedSignal* received = receivedSignals.acquire();
+			if (!received) {
+				TransmitterSignal discarded;
+				radio.read(&discarded, size < sizeof(discarded) ? size : sizeof(discarded));
+				droppedSignalsCount = droppedSignalsCount + 1;
+				continue;
+			}
+			received->time = time;
+			radio.read(&received->signal, size < sizeof(received->signal) ? size : sizeof(received->signal));
+			received->goodSignal = radio.testRPD();
+			receivedSignals.commit();
+		}
+	}
+
+	/// Watchdog tick (timer interrupt, 1 kHz): moves the outputs to failsafe
+	/// positions once the frames stop arriving.
+	void checkFailsafe()
+	{
+		if (!failsafe.check(hal::micros()))
+			return;
+		for (uint8_t i = 0; i < Board::outputsCount; i++) {
+			if (failsafeChannels[i].mode == FailsafeMode::Preset) {
+				board.setFailsafeOutput(i, failsafeChannels[i].position);
+			}
+		}
+	}
+
+	/// Main loop: keeps the link going, between the received signals.
+	void update()
+	{
+#if LINK_FHSS
+		updateHopping();
+#endif
+		reportFailsafe();
+		updateLinkScan();
+	}
+
+	/// Main loop: handles next received signal. Returns false if there is none.
+	bool handleSignal()
+	{
+		const ReceivedSignal* received = receivedSignals.peek();
+		if (!received)
+			return false;
+		onSignal(*received);
+		receivedSignals.release();
+		return true;
+	}
+
+	/// Preloads fresh status to be sent back with next acknowledgement.
+	void queueStatus()
+	{
+		rxSignal.packetType = PacketType::Status;
+		{
+			typename Board::InterruptLock lock;
+			batteryVoltage = batteryMonitor.millivolts();
+		}
+		rxSignal.statusPacket.flags = 0;
+		rxSignal.statusPacket.battery = batteryVoltage;
+		rxSignal.statusPacket.signalRating = linkQuality.rating();
+		rxSignal.statusPacket.goodSignal = linkQuality.strongPercent() > 50;
+		rxSignal.statusPacket.lossPercent = linkQuality.lossPercent();
+		rxSignal.statusPacket.longestGap = linkQuality.longestGap();
+		rxSignal.statusPacket.jitter = linkQuality.jitter();
+		rxSignal.statusPacket.linkProfile = linkProfile | (pendingLinkProfile << 4);
+		rxSignal.statusPacket.linkChannel = pendingLinkChannel;
+		board.writeAckPayload(rxSignal, statusSignalSize);
+	}
+
+	/// Preloads latency echo (of the frame taken by the outputs) instead of the status,
+	/// if there is one. Returns false if not, or if the previous one was echo already.
+	bool queueLatencyEcho()
+	{
+		if (echoQueued) {
+			echoQueued = false;
+			return false;
+		}
+		LatencyEchoPacket echo;
+		uint32_t receptionTime;
+		bool taken;
+		{
+			typename Board::InterruptLock lock;
+			taken = latencyProbe.takeEcho(echo, receptionTime);
+		}
+		if (!taken)
+			return false;
+
+		rxSignal.packetType = PacketType::LatencyEcho;
+		rxSignal.latencyEchoPacket = echo;
+		board.writeAckPayload(rxSignal, latencyEchoSignalSize);
+		echoQueued = true;
+
+		TelemetryLatencyRecord record;
+		record.time = receptionTime;
+		record.stamp = echo.stamp;
+		record.latchDelay = echo.latchDelay;
+		record.sequence = echo.sequence;
+		telemetry.write(record);
+		return true;
+	}
+
+	/// Switches the radio to given link profile; failsafe (and so the hopping)
+	/// starts from the nominal frame period of the profile.
+	void switchLinkProfile(uint8_t index)
+	{
+		linkProfile = index;
+		pendingLinkProfile = index;
+		board.setRadioProfile(linkProfiles[index]);
+		typename Board::InterruptLock lock;
+		failsafe.setFramePeriod(linkProfiles[index].framePeriod());
+	}
+
+	/// Switches to given link channel: the radio right away, or (with the
+	/// hopping) the sequence, taking over from next hop.
+	void switchLinkChannel(uint8_t channel)
+	{
+		linkChannel = channel;
+		pendingLinkChannel = channel;
+#if LINK_FHSS
+		hopTracker.hops = makeHopSequence(LINK_BIND_SEED, channel);
+#else
+		board.setChannel(fixedLinkChannel(channel));
+#endif
+	}
+
+private:
+	void onSignal(const ReceivedSignal& received)
+	{
+		const TransmitterSignal& txSignal = received.signal;
+		const bool stamped = txSignal.packetType == PacketType::LatencyControl;
+		if (txSignal.packetType != PacketType::Control && !stamped)
+			return;
+
+		const ControlFrame frame = txSignal.controlPacket.unpack();
+#if LINK_FHSS
+		if (!hopTracker.onFrame(frame.sequence, received.time))
+			return; // corrupted
+#endif
+		linkQuality.onFrame(frame.sequence, received.time, received.goodSignal);
+
+		// Failsafe
+		bool failsafeExited;
+		TelemetryFailsafeRecord failsafeRecord;
+		{
+			typename Board::InterruptLock lock;
+			failsafeExited = failsafe.feed(received.time, frame.sequence);
+			failsafeRecord.time = failsafe.lastExitTime;
+			failsafeRecord.silence = failsafe.lastExitSilence;
+			failsafeRecord.entriesCount = failsafe.entriesCount;
+		}
+		if (failsafeExited) {
+			reportFailsafe(); // entry first, if not reported yet
+			failsafeRecord.entered = 0;
+			failsafeRecord.latency = 0;
+			telemetry.write(failsafeRecord);
+		}
+
+		if (++framesSinceStatus >= statusAckInterval) {
+			framesSinceStatus = 0;
+			if (!queueLatencyEcho()) {
+				queueStatus();
+			}
+		}
+
+		// Telemetry
+		if (telemetry.tick()) {
+			TelemetryFrameRecord record;
+			record.time = received.time;
+			record.sequence = frame.sequence;
+			record.switches = frame.switches;
+			memcpy(record.channels, frame.channels, sizeof(record.channels));
+			record.signalRating = linkQuality.rating();
+			record.goodSignal = received.goodSignal;
+			record.linkProfile = linkProfile;
+			record._reserved = 0;
+			record.battery = batteryVoltage;
+			{
+				typename Board::InterruptLock lock;
+				record.droppedCount = droppedSignalsCount;
+			}
+			telemetry.write(record);
+		}
+
+		// Update outputs (all at once, so the output interrupts never take them half-updated)
+		{
+			typename Board::InterruptLock lock;
+			board.setOutputs(frame);
+			if (stamped) {
+				latencyProbe.onOutputs(txSignal.stamp, frame.sequence, received.time);
+			}
+		}
+
+		// Link profile & channel switches: announced, then done after the last sequence number (its ACK is out already)
+		if (frame.request == TransmitterRequest::LinkProfile && frame.extra < linkProfilesCount) {
+			pendingLinkProfile = frame.extra;
+			if (frame.sequence == controlSequenceMask && pendingLinkProfile != linkProfile) {
+				switchLinkProfile(pendingLinkProfile);
+			}
+		}
+		if (frame.request == TransmitterRequest::LinkChannel && isLinkChannelValid(frame.extra)) {
+			pendingLinkChannel = frame.extra;
+			if (frame.sequence == controlSequenceMask && pendingLinkChannel != linkChannel) {
+				switchLinkChannel(pendingLinkChannel);
+			}
+		}
+	}
+
+#if LINK_FHSS
+	/// Hops to next channel when it's time (after frame arrival, or following
+	/// the frame timer if frames are missed), and reports channels statistics.
+	void updateHopping()
+	{
+		uint32_t framePeriod;
+		{
+			typename Board::InterruptLock lock;
+			framePeriod = failsafe.framePeriod;
+		}
+		if (hopTracker.update(hal::micros(), framePeriod)) {
+			board.setChannel(hopTracker.channel());
+		}
+
+		if (hal::millis() - lastHopReportTime >= hopReportInterval) {
+			lastHopReportTime = hal::millis();
+			TelemetryHopRecord record;
+			record.index = reportedHopIndex;
+			record.channel = hopTracker.hops[reportedHopIndex];
+			record.receivedCount = hopTracker.stats[reportedHopIndex].receivedCount;
+			record.lostCount = hopTracker.stats[reportedHopIndex].lostCount;
+			record.resyncCount = hopTracker.resyncCount;
+			telemetry.write(record);
+			reportedHopIndex = (reportedHopIndex + 1) & (hopChannelsCount - 1);
+		}
+	}
+#endif
+
+	/// Reports failsafe entries noticed by the watchdog.
+	void reportFailsafe()
+	{
+		TelemetryFailsafeRecord record;
+		{
+			typename Board::InterruptLock lock;
+			if (failsafe.entriesCount == reportedFailsafeEntriesCount)
+				return;
+			reportedFailsafeEntriesCount = failsafe.entriesCount;
+			record.time = failsafe.lastEntryTime;
+			record.silence = failsafe.lastEntrySilence;
+			record.latency = failsafe.lastEntryLatency;
+			record.entriesCount = failsafe.entriesCount;
+		}
+		record.entered = 1;
+		telemetry.write(record);
+	}
+
+	/// Goes through the link profiles while the frames don't arrive, in case
+	/// the switch was missed (or the transmitter started with other profile).
+	/// Announced profile goes first, right after the failsafe kicks in. Link
+	/// channel goes back to the default first, as the transmitter does when
+	/// it gets no ACKs, to switch again once they meet there.
+	void updateLinkScan()
+	{
+		bool lost;
+		uint32_t lastFrameTime;
+		{
+			typename Board::InterruptLock lock;
+			lost = failsafe.active;
+			lastFrameTime = failsafe.lastFrameTime;
+		}
+		if (!lost)
+			return;
+		if (pendingLinkProfile != linkProfile) {
+			lastLinkScanTime = hal::millis();
+			switchLinkProfile(pendingLinkProfile);
+			return;
+		}
+		if (hal::micros() - lastFrameTime < linkScanDelay * 1000ul)
+			return;
+		if (linkChannel || pendingLinkChannel) {
+			lastLinkScanTime = hal::millis();
+			switchLinkChannel(0);
+			return;
+		}
+		if (hal::millis() - lastLinkScanTime < linkScanDwell)
+			return;
+		lastLinkScanTime = hal::millis();
+		switchLinkProfile((linkProfile + 1) % linkProfilesCount);
+	}
+};
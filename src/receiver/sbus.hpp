@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+
+/// SBUS frame, as sent to flight controllers: 100000 baud, 8E2, inverted
+/// (needs external inverter, as AVR UART can't invert), every 14 ms:
+///
+///     header (0x0F) | 16 channels by 11 bits (little-endian bit stream) | flags | footer (0x00)
+///
+/// Channel values map 880-2159 us to 0-2047 (so 1000-2000 us is 192-1792).
+struct SbusFrame
+{
+	static constexpr uint8_t header = 0x0F;
+	static constexpr uint8_t footer = 0x00;
+	static constexpr uint8_t channelsCount = 16;
+	static constexpr uint8_t channelBits = 11;
+	static constexpr uint16_t channelMax = (1 << channelBits) - 1;
+	static constexpr uint16_t usOffset = 880;
+
+	// Flags
+	static constexpr uint8_t frameLost = 1 << 2;
+	static constexpr uint8_t failsafe = 1 << 3;
+
+	uint8_t bytes[1 + channelsCount * channelBits / 8 + 1 + 1] = {};
+
+	static constexpr uint16_t fromMicroseconds(uint16_t us)
+	{
+		const uint32_t value = us < usOffset ? 0 : (static_cast<uint32_t>(us - usOffset) * 8 + 2) / 5;
+		return value < channelMax ? value : channelMax;
+	}
+
+	static constexpr uint16_t toMicroseconds(uint16_t value)
+	{
+		return usOffset + (static_cast<uint32_t>(value) * 5 + 4) / 8;
+	}
+
+	/// Packs given channels (us), the rest are centered (1500 us).
+	constexpr void pack(const uint16_t* channels, uint8_t count, uint8_t flags)
+	{
+		bytes[0] = header;
+		uint32_t bits = 0;
+		uint8_t bitsCount = 0;
+		uint8_t index = 1;
+		for (uint8_t i = 0; i < channelsCount; i++) {
+			const uint16_t value = fromMicroseconds(i < count ? channels[i] : 1500);
+			bits |= static_cast<uint32_t>(value) << bitsCount;
+			bitsCount += channelBits;
+			while (bitsCount >= 8) {
+				bytes[index++] = bits & 0xFF;
+				bits >>= 8;
+				bitsCount -= 8;
+			}
+		}
+		bytes[index++] = flags;
+		bytes[index] = footer;
+	}
+
+	constexpr uint16_t channel(uint8_t i) const
+	{
+		const uint16_t bit = i * channelBits;
+		const uint32_t bits = bytes[1 + bit / 8] | (bytes[2 + bit / 8] << 8) | (static_cast<uint32_t>(bytes[3 + bit / 8]) << 16);
+		return (bits >> (bit % 8)) & channelMax;
+	}
+};
+static_assert(sizeof(SbusFrame) == 25);
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+/// Servo pulse widths for the output engine, double-buffered: main code (or
+/// the failsafe) sets pending ones, the timer interrupt takes them all at
+/// once between the output frames (after the last pulse of the frame), so
+/// the channels change together. Pulses go one after another in each frame,
+/// as the software driven ones share single compare unit of the timer.
+/// Not thread-safe by itself: setting from the main code should be done
+/// with interrupts disabled.
+struct ServoOutputs
+{
+	static constexpr uint8_t count = 6;
+	static constexpr uint16_t minPulse = 700; // us
+	static constexpr uint16_t maxPulse = 2300; // us
+	static constexpr uint16_t framePeriod = 20'000; // us
+	static_assert(count * maxPulse < framePeriod, "all pulses must fit the frame, with time left for latching");
+
+	uint16_t pending[count] = {}; // us
+	uint16_t active[count] = {}; // us, used by the interrupts during current frame
+	bool changed = false; // pending ones, since last latch
+	uint16_t latchedCount = 0; // frames which took new values
+
+	constexpr void set(uint8_t i, uint16_t us)
+	{
+		pending[i] = us < minPulse ? minPulse : us > maxPulse ? maxPulse : us;
+		changed = true;
+	}
+
+	/// Takes pending widths for the next frame. Called between the frames.
+	constexpr void latch()
+	{
+		if (!changed)
+			return;
+		for (uint8_t i = 0; i < count; i++) active[i] = pending[i];
+		changed = false;
+		latchedCount += 1;
+	}
+};
+
+/// Lateness of the software driven pulse edges (interrupt entry after the
+/// compare match), in timer ticks.
+struct EdgeLateness
+{
+	uint16_t edgesCount = 0;
+	uint16_t max = 0;
+	uint32_t sum = 0;
+
+	inline void add(uint16_t lateness)
+	{
+		edgesCount += 1;
+		sum += lateness;
+		if (lateness > max) max = lateness;
+	}
+};
@@ -0,0 +1,364 @@
+// Link simulation on the host (`simulation` environment): the link code of
+// the firmware (`TransmitterLink` & `ReceiverLink`, with the packets, hopping,
+// link quality, failsafe & link profiles) run by the models of the transmitter
+// and the receiver, connected by simulated radios under the virtual time,
+// going through scenarios of various link conditions.
+//
+// Usage:
+//     program [--filter <text>] [--seed <number>]
+//
+// Reports for each scenario: delivered frames rate, stick-to-servo latency
+// distribution, failsafe entries (with detection latency and time spent),
+// and link quality/rating as reported back to the transmitter.
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include "common/hal.hpp"
+#include "transmitter/calibration.hpp"
+#include "transmitter/transmitter_link.hpp"
+#include "receiver/receiver_link.hpp"
+#include "sim_rf24.hpp"
+
+constexpr uint32_t timeStep = 25; // us, of the simulation
+
+constexpr AnalogChannelsCalibration calibration = {
+	{ .rawMin =  685, .rawCenter =  685, .rawMax = 1647, .usMin = 1000, .usCenter = 1000, .usMax = 2000 },
+	{ .rawMin =  663, .rawCenter = 1047, .rawMax = 1427, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =  680, .rawCenter = 1090, .rawMax = 1490, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin = 3793, .rawCenter = 3207, .rawMax = 2779, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =    0, .rawCenter = 2048, .rawMax = 4095, .usMin = 1000, .usCenter = 1500, .usMax = 2000 },
+	{ .rawMin =    0, .rawCenter =    0, .rawMax = 4095, .usMin = 1000, .usCenter = 1000, .usMax = 2000 },
+};
+
+void setRadioProfile(SimRF24& radio, const LinkProfile& profile)
+{
+	radio.setDataRate(profile.dataRate);
+	radio.setCRCLength(profile.crcLength);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Transmitter model (radio task of the transmitter)
+
+struct TransmitterModel
+{
+	SimRF24 radio;
+	TransmitterLink<SimRF24> link;
+	CompiledCalibration compiledCalibration;
+	uint32_t nextFrameTime = 0; // us
+
+	// What was sent, by sequence, to measure latency & detect corruption at the receiver
+	uint32_t sampleTimes[controlSequenceMask + 1] = {};
+	uint16_t sentChannels[controlSequenceMask + 1][controlChannelsCount] = {};
+
+	uint32_t statusCount = 0;
+	uint32_t lastStatusTime = 0;
+	uint32_t maxStatusAge = 0; // us
+	std::vector<uint8_t> ratings; // from the received statuses
+	std::vector<uint8_t> losses;  // percent, from the received statuses
+
+	uint8_t linkChannel; // selected
+
+	TransmitterModel(SimAir& air, uint8_t linkProfile, uint8_t linkChannel)
+		: radio(air), link(radio, linkProfile), linkChannel(linkChannel)
+	{
+		compiledCalibration.update(calibration);
+		setRadioProfile(radio, linkProfiles[linkProfile]);
+	}
+
+	/// Sticks moving around, as raw analog values.
+	static void sampleSticks(uint32_t now, uint16_t* raw)
+	{
+		const double t = now / 1e6;
+		for (uint8_t i = 0; i < 6; i++) {
+			const auto& c = calibration[i];
+			const double phase = std::sin(2 * M_PI * (0.3 + 0.2 * i) * t);
+			raw[i] = c.rawCenter + (phase >= 0 ? (c.rawMax - c.rawCenter) : (c.rawCenter - c.rawMin)) * phase;
+		}
+	}
+
+	void loop(uint32_t now)
+	{
+		if (static_cast<int32_t>(now - nextFrameTime) < 0)
+			return;
+		nextFrameTime += linkProfiles[link.state.linkProfile].framePeriod();
+
+		uint16_t raw[6];
+		uint16_t mapped[6];
+		sampleSticks(now, raw);
+		compiledCalibration.map(raw, mapped);
+
+		auto& frame = link.state.controlFrame;
+		for (uint8_t i = 0; i < 5; i++) {
+			frame.channels[i] = mapped[i];
+		}
+		for (uint8_t i = 0; i < 3; i++) {
+			frame.setAux(i, (now / 1'000'000 + i) % 2);
+			frame.channels[5 + i] = frame.aux(i) ? 1000 : 2000;
+		}
+		link.pack(link.state.linkProfile, linkChannel, false, now);
+		const ControlFrame sent = link.txSignal.controlPacket.unpack(); // as limited by the packing
+		sampleTimes[sent.sequence] = now;
+		memcpy(sentChannels[sent.sequence], sent.channels, sizeof(sent.channels));
+
+		link.write();
+		if (statusCount && now - lastStatusTime > maxStatusAge) {
+			maxStatusAge = now - lastStatusTime;
+		}
+		if (link.receive()) {
+			statusCount += 1;
+			lastStatusTime = now;
+			ratings.push_back(link.state.rxSignal.statusPacket.signalRating);
+			losses.push_back(link.state.rxSignal.statusPacket.lossPercent);
+		}
+		if (link.endFrame()) {
+			setRadioProfile(radio, linkProfiles[link.state.linkProfile]);
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Receiver model (main loop, radio & timer interrupts of the receiver), as the board of the link
+
+struct ReceiverModel
+{
+	static constexpr uint8_t outputsCount = 6;
+	static constexpr uint16_t batteryRaw = 505; // ~7.4 V
+
+	/// No interrupts in the simulation: each step runs to its end.
+	struct InterruptLock
+	{
+		InterruptLock() {}
+	};
+
+	SimRF24 radio;
+	ReceiverLink<ReceiverModel> link { *this };
+	uint16_t outputs[outputsCount] = {};
+
+	// Results
+	const TransmitterModel& transmitter;
+	std::vector<uint32_t> latencies; // us, stick sample to servo output
+	uint32_t appliedCount = 0;
+	uint32_t corruptedAppliedCount = 0;
+	uint32_t failsafeTime = 0; // us, in total
+	uint32_t maxEntrySilence = 0; // us
+
+	ReceiverModel(SimAir& air, const TransmitterModel& transmitter, uint8_t linkProfile) : radio(air), transmitter(transmitter)
+	{
+		for (uint8_t i = 0; i < outputsCount; i++) {
+			outputs[i] = failsafeChannels[i].mode == FailsafeMode::Preset ? failsafeChannels[i].position : 1500;
+		}
+		link.telemetry.decimation = 0; // no serial port
+		link.batteryMonitor.add(batteryRaw);
+		link.linkProfile = linkProfile;
+		link.pendingLinkProfile = linkProfile;
+		link.begin();
+	}
+
+	// Board
+
+	void setOutputs(const ControlFrame& frame)
+	{
+		for (uint8_t i = 0; i < outputsCount; i++) {
+			outputs[i] = std::clamp<uint16_t>(frame.channels[i], 700, 2300);
+		}
+		appliedCount += 1;
+		if (memcmp(frame.channels, transmitter.sentChannels[frame.sequence], sizeof(frame.channels)) != 0) {
+			corruptedAppliedCount += 1;
+		}
+		else {
+			latencies.push_back(hal::micros() - transmitter.sampleTimes[frame.sequence]);
+		}
+	}
+
+	void setFailsafeOutput(uint8_t index, uint16_t us)
+	{
+		outputs[index] = us;
+	}
+
+	void setChannel(uint8_t channel)
+	{
+		radio.setChannel(channel);
+	}
+
+	void setRadioProfile(const LinkProfile& profile)
+	{
+		::setRadioProfile(radio, profile);
+	}
+
+	void writeAckPayload(const ReceiverSignal& signal, uint8_t size)
+	{
+		radio.writeAckPayload(1, &signal, size);
+	}
+
+	// Interrupts & main loop
+
+	/// Failsafe watchdog timer interrupt (1 kHz), also taking the battery conversions.
+	void timerTick()
+	{
+		if (link.failsafe.active) {
+			failsafeTime += 1'000;
+		}
+		link.checkFailsafe();
+		maxEntrySilence = std::max(maxEntrySilence, link.failsafe.lastEntrySilence);
+		link.batteryMonitor.add(batteryRaw);
+	}
+
+	void loop()
+	{
+		if (radio.available()) {
+			link.receive(radio, radio.arrivalTime());
+		}
+		link.update();
+		link.handleSignal();
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Scenarios
+
+struct Scenario
+{
+	const char* name;
+	uint8_t linkProfile; // index in `linkProfiles`
+	uint8_t linkChannel; // selected at the transmitter, see `TransmitterRequest::LinkChannel`
+	uint32_t duration; // us
+	LinkConditions conditions;
+};
+
+std::vector<Scenario> makeScenarios()
+{
+	std::vector<Scenario> scenarios;
+	auto add = [&](const char* name, uint8_t linkProfile, LinkConditions conditions, uint8_t linkChannel = 0) {
+		scenarios.push_back({ name, linkProfile, linkChannel, 10'000'000, conditions });
+	};
+
+	LinkConditions clean;
+	clean.latency = 300; // interrupt & SPI reading at the receiver
+	clean.latencyJitter = 100;
+	add("clean 50 Hz (CRC-16)", 0, clean);
+	add("clean 100 Hz", 1, clean);
+	add("clean 250 Hz", 2, clean);
+	add("clean 500 Hz", 3, clean);
+
+	LinkConditions c = clean;
+	c.lossModel = LossModel::Bernoulli;
+	c.lossProbability = 0.05;
+	add("bernoulli 5%", 1, c);
+	c.lossProbability = 0.20;
+	add("bernoulli 20%", 1, c);
+
+	c = clean;
+	c.lossModel = LossModel::GilbertElliott;
+	c.goodToBadProbability = 0.01;
+	c.badToGoodProbability = 0.10;
+	c.goodLossProbability = 0.01;
+	c.badLossProbability = 0.80;
+	add("gilbert-elliott bursts", 1, c);
+
+	c = clean;
+	c.outages = { { 3'000'000, 3'500'000 }, { 6'000'000, 8'000'000 } };
+	add("outages 0.5 s & 2 s", 1, c);
+
+	c = clean;
+#if LINK_FHSS
+	c.jammedChannels.assign(hopSequence.channels, hopSequence.channels + 8); // quarter of the hops
+	add("8 hop channels jammed", 1, c);
+	c.jammedChannels.clear();
+	for (uint8_t channel = 30; channel <= 52; channel++) c.jammedChannels.push_back(channel); // Wi-Fi channel 6
+	add("wi-fi band busy", 1, c);
+	add("wi-fi band avoided", 1, c, 41);
+#else
+	c.jammedChannels = { 76 };
+	add("working channel jammed", 1, c);
+	add("link channel switched", 1, clean, 40);
+#endif
+
+	c = clean;
+	c.corruptionProbability = 0.01;
+	add("corruption 1%", 1, c);
+
+	c = clean;
+	c.latency = 2'000;
+	c.latencyJitter = 3'000;
+	add("latency 2-5 ms", 1, c);
+
+	return scenarios;
+}
+
+uint32_t percentile(std::vector<uint32_t>& values, uint8_t percent)
+{
+	if (values.empty()) return 0;
+	const size_t index = std::min(values.size() - 1, values.size() * percent / 100);
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+template <typename T>
+double average(const std::vector<T>& values)
+{
+	double sum = 0;
+	for (const auto& v : values) sum += v;
+	return values.empty() ? 0 : sum / values.size();
+}
+
+void run(const Scenario& scenario, uint32_t seed)
+{
+	hal::virtualNanos = 0;
+	SimAir air(scenario.conditions, seed);
+	TransmitterModel transmitter(air, scenario.linkProfile, scenario.linkChannel);
+	ReceiverModel receiver(air, transmitter, scenario.linkProfile);
+	transmitter.radio.connect(receiver.radio);
+
+	uint32_t nextTimerTick = 0;
+	for (uint32_t now = 0; now < scenario.duration; now += timeStep) {
+		hal::virtualNanos = static_cast<uint64_t>(now) * 1'000;
+		transmitter.loop(now);
+		if (now >= nextTimerTick) {
+			nextTimerTick += 1'000;
+			receiver.timerTick();
+		}
+		receiver.loop();
+	}
+
+	const double seconds = scenario.duration / 1e6;
+	auto& latencies = receiver.latencies;
+	const uint8_t minRating = transmitter.ratings.empty() ? 0 : *std::min_element(transmitter.ratings.begin(), transmitter.ratings.end());
+	printf("%-24s %4u Hz | applied %6.1f Hz, air loss %4.1f%%, corrupted %3u | latency [us] p50 %5u p99 %5u max %5u"
+		" | failsafe %2u x, detect max %4u us, silence max %6u us, total %5.2f s"
+		" | status %4u, age max %4u ms, rating avg %5.1f min %3u, loss avg %4.1f%%\n",
+		scenario.name, linkProfiles[scenario.linkProfile].frameRate,
+		receiver.appliedCount / seconds,
+		air.packetsCount ? 100.0 * air.lostCount / air.packetsCount : 0.0,
+		receiver.corruptedAppliedCount,
+		percentile(latencies, 50), percentile(latencies, 99), percentile(latencies, 100),
+		receiver.link.failsafe.entriesCount, receiver.link.failsafe.maxEntryLatency, receiver.maxEntrySilence,
+		receiver.failsafeTime / 1e6,
+		transmitter.statusCount, transmitter.maxStatusAge / 1'000,
+		average(transmitter.ratings), minRating, average(transmitter.losses));
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = nullptr;
+	uint32_t seed = 1;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 0);
+		else {
+			fprintf(stderr, "Usage: %s [--filter <text>] [--seed <number>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("Link simulation (FHSS %s, seed %u)\n", LINK_FHSS ? "on" : "off", seed);
+	for (const auto& scenario : makeScenarios()) {
+		if (filter && !strstr(scenario.name, filter))
+			continue;
+		run(scenario, seed);
+	}
+	return 0;
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <random>
+#include <vector>
+#include "common/hal.hpp"
+#include "common/link_profiles.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Loss models
+
+enum class LossModel : uint8_t
+{
+	None,
+	Bernoulli,      // independent losses with given probability
+	GilbertElliott, // two-state Markov chain: good & bad (burst) states, each with own loss probability
+};
+
+struct LinkConditions
+{
+	LossModel lossModel = LossModel::None;
+	double lossProbability = 0; // Bernoulli
+
+	// Gilbert-Elliott (per packet transitions)
+	double goodToBadProbability = 0;
+	double badToGoodProbability = 1;
+	double goodLossProbability = 0;
+	double badLossProbability = 1;
+
+	uint32_t latency = 0; // us, on top of the air time (like SPI & interrupt handling)
+	uint32_t latencyJitter = 0; // us, uniformly added
+	double corruptionProbability = 0; // of delivered payload getting single bit flipped (escaping the CRC)
+
+	std::vector<uint8_t> jammedChannels; // RF channels losing everything
+
+	struct Outage { uint32_t from, to; }; // us
+	std::vector<Outage> outages; // periods losing everything
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Air
+
+class SimRF24;
+
+/// Shared medium between simulated radios, applying the link conditions.
+/// Single transmitter (PTX) and single receiver (PRX), as in the real link.
+class SimAir
+{
+public:
+	LinkConditions conditions;
+	std::mt19937 random;
+
+	// Statistics
+	uint32_t packetsCount = 0;
+	uint32_t lostCount = 0;
+	uint32_t corruptedCount = 0;
+
+	SimAir(const LinkConditions& conditions, uint32_t seed) : conditions(conditions), random(seed) {}
+
+	/// Decides whether packet sent now on given channel is lost.
+	bool lose(uint8_t channel)
+	{
+		packetsCount += 1;
+		const uint32_t now = hal::micros();
+		bool lost = false;
+		for (const auto& outage : conditions.outages) {
+			if (outage.from <= now && now < outage.to) lost = true;
+		}
+		for (const uint8_t jammed : conditions.jammedChannels) {
+			if (jammed == channel) lost = true;
+		}
+		switch (conditions.lossModel) {
+			case LossModel::Bernoulli:
+				lost |= chance(conditions.lossProbability);
+				break;
+			case LossModel::GilbertElliott:
+				if (bad) bad = !chance(conditions.badToGoodProbability);
+				else bad = chance(conditions.goodToBadProbability);
+				lost |= chance(bad ? conditions.badLossProbability : conditions.goodLossProbability);
+				break;
+			default:
+				break;
+		}
+		lostCount += lost;
+		return lost;
+	}
+
+	uint32_t latency()
+	{
+		uint32_t l = conditions.latency;
+		if (conditions.latencyJitter) l += std::uniform_int_distribution<uint32_t>(0, conditions.latencyJitter)(random);
+		return l;
+	}
+
+	void corrupt(uint8_t* payload, uint8_t length)
+	{
+		if (length && chance(conditions.corruptionProbability)) {
+			const uint32_t bit = std::uniform_int_distribution<uint32_t>(0, length * 8 - 1)(random);
+			payload[bit / 8] ^= 1 << (bit % 8);
+			corruptedCount += 1;
+		}
+	}
+
+	bool chance(double probability)
+	{
+		return probability > 0 && std::uniform_real_distribution<double>(0, 1)(random) < probability;
+	}
+
+private:
+	bool bad = false; // Gilbert-Elliott state
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Radio
+
+/// Stand-in for the `RF24` class (subset used by the project, same names),
+/// with auto-acknowledgement, ACK payloads and dynamic payloads always on.
+/// Writing is instant in the virtual time (returns the result right away),
+/// the payload arrives to the other side after the air time & latency.
+class SimRF24
+{
+public:
+	static constexpr uint8_t fifoSize = 3;
+	static constexpr uint8_t maxPayloadSize = 32;
+
+	struct Payload
+	{
+		uint32_t arrivalTime; // us
+		uint8_t length;
+		uint8_t data[maxPayloadSize];
+	};
+
+	SimRF24(SimAir& air) : air(air) {}
+
+	/// Connects the transmitter (this) with the receiver.
+	void connect(SimRF24& receiver) { peer = &receiver; }
+
+	void setChannel(uint8_t channel) { this->channel = channel < 125 ? channel : 125; }
+	uint8_t getChannel() const { return channel; }
+
+	/// Both sides must use the same air data rate & CRC length, as the real radios.
+	void setDataRate(uint8_t dataRate) { this->dataRate = dataRate; }
+	void setCRCLength(uint8_t crcLength) { this->crcLength = crcLength; }
+
+	/// Sends the payload to the connected receiver, returns whether it was
+	/// acknowledged (ACK payload, if any, becomes available to read).
+	bool write(const void* buffer, uint8_t length)
+	{
+		if (!peer || length > maxPayloadSize) return false;
+		const uint32_t now = hal::micros();
+		if (peer->channel != channel || peer->dataRate != dataRate || peer->crcLength != crcLength || air.lose(channel))
+			return false;
+
+		Payload payload;
+		payload.arrivalTime = now + LinkProfile::airTime(dataRate, crcLength, length) + air.latency();
+		payload.length = length;
+		memcpy(payload.data, buffer, length);
+		air.corrupt(payload.data, length);
+		if (peer->rxFifo.size() >= fifoSize)
+			return false; // receiver doesn't acknowledge with full FIFO
+		peer->rxFifo.push_back(payload);
+
+		// Acknowledgement goes back right after (same channel), possibly with the payload
+		if (air.lose(channel))
+			return false;
+		if (!peer->ackFifo.empty()) {
+			Payload ack = peer->ackFifo.front();
+			peer->ackFifo.pop_front();
+			ack.arrivalTime = now;
+			rxFifo.push_back(ack);
+			if (rxFifo.size() > fifoSize) rxFifo.pop_front();
+		}
+		return true;
+	}
+
+	/// Returns true if there is payload already arrived (by the virtual time).
+	bool available() const
+	{
+		return !rxFifo.empty() && static_cast<int32_t>(hal::micros() - rxFifo.front().arrivalTime) >= 0;
+	}
+
+	uint8_t getDynamicPayloadSize() const
+	{
+		return rxFifo.empty() ? 0 : rxFifo.front().length;
+	}
+
+	/// Arrival time of next payload (us), like the IRQ timestamp.
+	uint32_t arrivalTime() const
+	{
+		return rxFifo.empty() ? 0 : rxFifo.front().arrivalTime;
+	}
+
+	void read(void* buffer, uint8_t length)
+	{
+		if (rxFifo.empty()) return;
+		const Payload& payload = rxFifo.front();
+		memcpy(buffer, payload.data, length < payload.length ? length : payload.length);
+		rxFifo.pop_front();
+	}
+
+	bool writeAckPayload(uint8_t /*pipe*/, const void* buffer, uint8_t length)
+	{
+		if (ackFifo.size() >= fifoSize || length > maxPayloadSize) return false;
+		Payload payload {};
+		payload.length = length;
+		memcpy(payload.data, buffer, length);
+		ackFifo.push_back(payload);
+		return true;
+	}
+
+	/// Signal above -64 dBm: no power model, so strong unless in bad conditions.
+	bool testRPD() { return !air.chance(0.1); }
+
+private:
+	SimAir& air;
+	SimRF24* peer = nullptr;
+	uint8_t channel = 76; // RF24 default
+	uint8_t dataRate = 0; // RF24 default: 1 Mbps
+	uint8_t crcLength = 2; // RF24 default: 16 bits
+	std::deque<Payload> rxFifo;
+	std::deque<Payload> ackFifo;
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/adc.h>
+#include "snapshot.hpp"
+
+enum class AnalogFilter : uint8_t
+{
+	None,
+	LowPass, // exponential moving average, parameter is the smoothing shift (alpha = 1/2^n)
+	Median,  // median of last 5 (oversampled) values, parameter unused
+};
+
+struct AnalogInputConfig
+{
+	uint8_t pin;
+	AnalogFilter filter;
+	uint8_t parameter;
+};
+
+/// Background sampling of the analog inputs, using the continuous (DMA) mode
+/// of the ADC1. Each input is oversampled (averaged) and filtered, latest
+/// values are available as a lock-free snapshot, so no conversion has to be
+/// waited for when the values are needed.
+struct AnalogSampler
+{
+	static constexpr uint8_t maxInputsCount = 8;
+	static constexpr uint8_t oversampling = 16; // conversions averaged per value
+	static constexpr uint32_t sampleFrequency = 48'000; // Hz, in total for all inputs
+
+	static constexpr BaseType_t taskCore = 0; // alongside the radio task
+	static constexpr UBaseType_t taskPriority = 4; // below the radio task
+	static constexpr uint32_t taskStackSize = 3072;
+
+	struct Values
+	{
+		uint16_t values[maxInputsCount];
+	};
+
+	const AnalogInputConfig* inputs;
+	uint8_t inputsCount;
+	int8_t channelToInput[10]; // ADC1 channel -> input index, or -1
+
+	Snapshot<Values> snapshot;
+
+	inline Values load() const { return snapshot.load(); }
+
+	void begin(const AnalogInputConfig* inputs, uint8_t inputsCount)
+	{
+		this->inputs = inputs;
+		this->inputsCount = min<uint8_t>(inputsCount, maxInputsCount);
+
+		adc_digi_pattern_config_t patterns[maxInputsCount] = {};
+		uint32_t channelsMask = 0;
+		for (auto& i : channelToInput) i = -1;
+		for (uint8_t i = 0; i < this->inputsCount; i++) {
+			const uint8_t channel = digitalPinToAnalogChannel(inputs[i].pin);
+			channelToInput[channel] = i;
+			channelsMask |= 1 << channel;
+			patterns[i].atten = ADC_ATTEN_DB_11; // same as `analogRead` default, to keep the calibration
+			patterns[i].channel = channel;
+			patterns[i].unit = 0; // ADC1
+			patterns[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+		}
+
+		adc_digi_init_config_t initConfig = {
+			.max_store_buf_size = 4 * bytesPerRead(),
+			.conv_num_each_intr = bytesPerRead(),
+			.adc1_chan_mask = channelsMask,
+			.adc2_chan_mask = 0,
+		};
+		ESP_ERROR_CHECK(adc_digi_initialize(&initConfig));
+
+		adc_digi_configuration_t config = {
+			.conv_limit_en = false,
+			.conv_limit_num = 250,
+			.pattern_num = this->inputsCount,
+			.adc_pattern = patterns,
+			.sample_freq_hz = sampleFrequency,
+			.conv_mode = ADC_CONV_SINGLE_UNIT_1,
+			.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+		};
+		ESP_ERROR_CHECK(adc_digi_controller_configure(&config));
+		ESP_ERROR_CHECK(adc_digi_start());
+
+		xTaskCreatePinnedToCore(taskMain, "analog", taskStackSize, this, taskPriority, nullptr, taskCore);
+	}
+
+private:
+	// Filters state
+	uint32_t lowPassStates[maxInputsCount] = {}; // Q4 fixed point
+	uint16_t medianHistory[maxInputsCount][5] = {};
+	uint8_t medianIndex = 0;
+	bool primed = false;
+
+	inline uint32_t bytesPerRead() const
+	{
+		return inputsCount * oversampling * SOC_ADC_DIGI_RESULT_BYTES;
+	}
+
+	static void taskMain(void* param)
+	{
+		auto& self = *static_cast<AnalogSampler*>(param);
+		alignas(uint32_t) uint8_t buffer[maxInputsCount * oversampling * SOC_ADC_DIGI_RESULT_BYTES];
+		while (true) {
+			uint32_t length = 0;
+			if (adc_digi_read_bytes(buffer, self.bytesPerRead(), &length, portMAX_DELAY) != ESP_OK)
+				continue; // overflow, values will come in next read
+			self.process(buffer, length);
+		}
+	}
+
+	void process(const uint8_t* buffer, uint32_t length)
+	{
+		uint32_t sums[maxInputsCount] = {};
+		uint16_t counts[maxInputsCount] = {};
+		for (uint32_t offset = 0; offset + SOC_ADC_DIGI_RESULT_BYTES <= length; offset += SOC_ADC_DIGI_RESULT_BYTES) {
+			const auto* result = reinterpret_cast<const adc_digi_output_data_t*>(buffer + offset);
+			if (result->type2.unit != 0 || result->type2.channel >= sizeof(channelToInput))
+				continue;
+			const int8_t i = channelToInput[result->type2.channel];
+			if (i < 0)
+				continue;
+			sums[i] += result->type2.data;
+			counts[i] += 1;
+		}
+
+		Values output = snapshot.load();
+		for (uint8_t i = 0; i < inputsCount; i++) {
+			if (counts[i] == 0)
+				continue;
+			const uint16_t value = (sums[i] + counts[i] / 2) / counts[i];
+			output.values[i] = filter(i, value);
+		}
+		medianIndex = (medianIndex + 1) % 5;
+		primed = true;
+		snapshot.store(output);
+	}
+
+	uint16_t filter(uint8_t i, uint16_t value)
+	{
+		switch (inputs[i].filter) {
+			case AnalogFilter::LowPass: {
+				auto& state = lowPassStates[i];
+				if (!primed) state = value << 4;
+				state += ((static_cast<int32_t>(value << 4) - static_cast<int32_t>(state)) >> inputs[i].parameter);
+				return (state + 8) >> 4;
+			}
+			case AnalogFilter::Median: {
+				auto& history = medianHistory[i];
+				if (!primed) for (auto& h : history) h = value;
+				history[medianIndex] = value;
+				uint16_t sorted[5];
+				memcpy(sorted, history, sizeof(sorted));
+				for (uint8_t a = 1; a < 5; a++) {
+					for (uint8_t b = a; b > 0 && sorted[b - 1] > sorted[b]; b--) {
+						std::swap(sorted[b - 1], sorted[b]);
+					}
+				}
+				return sorted[2];
+			}
+			default:
+				return value;
+		}
+	}
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+/// Same as Arduino `map()` (ESP32 variant, including the invalid range case),
+/// kept here as the reference for the compiled calibration.
+constexpr long arduinoMap(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	const long run = inMax - inMin;
+	if (run == 0) {
+		return -1;
+	}
+	const long rise = outMax - outMin;
+	const long delta = x - inMin;
+	return (delta * rise) / run + outMin;
+}
+
+/// Maps raw analog value to microseconds using the calibration. It's reference
+/// implementation, slow-ish (branches, multiply & divide), used to compile
+/// the lookup tables.
+constexpr uint16_t mapAnalogValue(uint16_t value, const AnalogChannelCalibrationData& calibration)
+{
+	// The safety constrain is applied in the receiver side, keeping servos in range 700-2300 us.
+	if (calibration.rawMin == calibration.rawCenter) {
+		// Single linear curve based on min & max values
+		return arduinoMap(value, calibration.rawMin, calibration.rawMax, calibration.usMin, calibration.usMax);
+	}
+	else /* rawMin != rawCenter */ {
+		// Two curves based on min & center and center & max values
+		if (value < calibration.rawCenter)
+			return arduinoMap(value, calibration.rawMin, calibration.rawCenter, calibration.usMin, calibration.usCenter);
+		else
+			return arduinoMap(value, calibration.rawCenter, calibration.rawMax, calibration.usCenter, calibration.usMax);
+	}
+}
+
+constexpr uint16_t analogValuesCount = 4096; // 12-bit ADC
+
+/// Calibration of single channel compiled into raw-to-microseconds lookup table.
+struct CalibrationTable
+{
+	uint16_t values[analogValuesCount] = {};
+
+	constexpr void compile(const AnalogChannelCalibrationData& calibration)
+	{
+		for (uint16_t raw = 0; raw < analogValuesCount; raw++) {
+			values[raw] = mapAnalogValue(raw, calibration);
+		}
+	}
+
+	constexpr uint16_t map(uint16_t raw) const
+	{
+		return values[raw & (analogValuesCount - 1)];
+	}
+};
+
+/// Lookup tables for all the channels, recompiled only for the channels
+/// which calibration changed since last update.
+struct CompiledCalibration
+{
+	static constexpr uint8_t channelsCount = sizeof(AnalogChannelsCalibration) / sizeof(AnalogChannelCalibrationData);
+
+	AnalogChannelsCalibration source = {};
+	CalibrationTable tables[channelsCount];
+	bool compiled = false;
+
+	/// Recompiles tables for changed channels, returns number of them.
+	uint8_t update(const AnalogChannelsCalibration& calibration)
+	{
+		uint8_t changedCount = 0;
+		for (uint8_t i = 0; i < channelsCount; i++) {
+			const auto& c = calibration[i];
+			auto& s = source[i];
+			if (compiled
+				&& s.rawMin == c.rawMin && s.rawCenter == c.rawCenter && s.rawMax == c.rawMax
+				&& s.usMin == c.usMin && s.usCenter == c.usCenter && s.usMax == c.usMax
+			) {
+				continue;
+			}
+			s = c;
+			tables[i].compile(s);
+			changedCount += 1;
+		}
+		compiled = true;
+		return changedCount;
+	}
+
+	inline void map(const uint16_t* raw, uint16_t* mapped) const
+	{
+		for (uint8_t i = 0; i < channelsCount; i++) {
+			mapped[i] = tables[i].map(raw[i]);
+		}
+	}
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+/// Two instances of a value: writer task prepares the spare one (which may
+/// take a while, like compiling lookup tables), then publishes it by a pointer
+/// swap; reader task takes the published one at its own pace (like at the
+/// frame start) and uses it until next take, never waiting. Writer touches
+/// the spare only after the reader took the latest published one, so single
+/// writer & single reader only.
+template <typename T>
+class DoubleBuffer
+{
+	T buffers[2];
+	std::atomic<T*> published = &buffers[0];
+	std::atomic<T*> taken = &buffers[0]; // by the reader
+
+public:
+	/// Writer: calls `update(T& spare)` (returning true if changed it), publishing
+	/// the spare if so. Returns false if the reader still uses the other one
+	/// (nothing done, to be tried again later).
+	template <typename Update>
+	bool update(Update&& update)
+	{
+		T* current = published.load(std::memory_order_acquire);
+		if (taken.load(std::memory_order_acquire) != current)
+			return false;
+		T* spare = current == &buffers[0] ? &buffers[1] : &buffers[0];
+		if (update(*spare)) {
+			published.store(spare, std::memory_order_release);
+		}
+		return true;
+	}
+
+	/// Reader: takes the latest published value, valid until next call.
+	const T& take()
+	{
+		T* current = published.load(std::memory_order_acquire);
+		taken.store(current, std::memory_order_release);
+		return *current;
+	}
+};
@@ -0,0 +1,11 @@
+#include "frame_scheduler.hpp"
+
+void IRAM_ATTR onFrameTimer()
+{
+	frameScheduler.lastTickTime = esp_timer_get_time();
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	vTaskNotifyGiveFromISR(frameScheduler.task, &higherPriorityTaskWoken);
+	if (higherPriorityTaskWoken) {
+		portYIELD_FROM_ISR();
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "timing_stats.hpp"
+
+void IRAM_ATTR onFrameTimer();
+
+/// Hardware timer driven scheduler for the control frames. Timer interrupt
+/// wakes the radio task at exact intervals; the scheduler measures how late
+/// the task actually starts each frame (jitter), how long the frame work took
+/// and how many frames were missed because previous one was still running.
+/// All of it is done by the radio task; other tasks only read the values
+/// (for displaying) and request the statistics reset.
+struct FrameScheduler
+{
+	static constexpr uint8_t timerNumber = 0;
+	static constexpr uint16_t timerDivider = 80; // 80 MHz APB clock -> 1 us ticks
+
+	hw_timer_t* timer = nullptr;
+	TaskHandle_t task = nullptr;
+	uint16_t frameRate = 100; // Hz, set by the link profile
+
+	volatile int64_t lastTickTime = 0; // us, set by the timer interrupt
+	int64_t frameStartTime = 0; // us
+
+	TimingStats jitter;   // us, from timer tick to frame start
+	TimingStats loopTime; // us, frame work duration
+	uint32_t framesCount = 0;
+	uint32_t missedCount = 0; // frames skipped, because previous frame took too long
+	std::atomic<bool> resetRequested = false; // by other task, done at next frame start
+
+	inline uint16_t rate() const { return frameRate; }
+	inline uint32_t interval() const { return 1'000'000 / rate(); } // us
+	inline uint32_t elapsed() const { return esp_timer_get_time() - frameStartTime; } // us, of current frame
+
+	/// Starts the timer, waking up calling task on each frame.
+	void begin()
+	{
+		task = xTaskGetCurrentTaskHandle();
+		timer = timerBegin(timerNumber, timerDivider, true);
+		timerAttachInterrupt(timer, &onFrameTimer, true);
+		timerAlarmWrite(timer, interval(), true);
+		timerAlarmEnable(timer);
+	}
+
+	/// Changes the rate, resetting the statistics (radio task only, on the link profile switch).
+	void setRate(uint16_t hz)
+	{
+		frameRate = hz;
+		if (timer) {
+			timerAlarmWrite(timer, interval(), true);
+			resetStats();
+		}
+	}
+
+	void resetStats()
+	{
+		jitter.reset();
+		loopTime.reset();
+		framesCount = 0;
+		missedCount = 0;
+	}
+
+	/// Statistics reset from other task, done by the radio task at next frame.
+	inline void requestResetStats() { resetRequested = true; }
+
+	/// Blocks until next frame should be started.
+	void waitForFrame()
+	{
+		const uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		frameStartTime = esp_timer_get_time();
+		if (resetRequested.exchange(false)) {
+			resetStats();
+		}
+		if (ticks > 1) {
+			missedCount += ticks - 1;
+		}
+		jitter.add(frameStartTime - lastTickTime);
+	}
+
+	/// Marks current frame work as done.
+	void endFrame()
+	{
+		framesCount += 1;
+		loopTime.add(esp_timer_get_time() - frameStartTime);
+	}
+};
+inline FrameScheduler frameScheduler;
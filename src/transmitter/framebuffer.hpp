@@ -0,0 +1,221 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7735.h>
+#include <driver/spi_master.h>
+#include <atomic>
+#include "timing_stats.hpp"
+
+/// ST7735 driver used only for the initialization, exposing the RAM offsets
+/// (different for various panels and rotations) for the frame buffer flushing.
+class ST7735Panel : public Adafruit_ST7735
+{
+public:
+	using Adafruit_ST7735::Adafruit_ST7735;
+	inline int16_t xOffset() const { return _xstart; }
+	inline int16_t yOffset() const { return _ystart; }
+};
+
+/// Off-screen RGB565 frame buffer the pages render into. On `flush()` the frame
+/// is handed over to the display task, which compares it with what the display
+/// already shows and pushes only the changed regions (in horizontal bands),
+/// using DMA transfers queued on the SPI bus, while the UI renders next frame.
+class FrameBuffer : public GFXcanvas16
+{
+public:
+	static constexpr int16_t screenWidth = 160;
+	static constexpr int16_t screenHeight = 80;
+	static constexpr int16_t bandHeight = 8;
+	static constexpr size_t bytesCount = screenWidth * screenHeight * sizeof(uint16_t);
+	static constexpr size_t bandBytesCount = screenWidth * bandHeight * sizeof(uint16_t);
+
+	static constexpr BaseType_t taskCore = 1; // same as the UI, radio has the other one
+	static constexpr UBaseType_t taskPriority = 2; // above the Arduino `loop()`
+	static constexpr uint32_t taskStackSize = 3072;
+
+	TimingStats flushTime; // us, pushing the changes of single frame
+	TimingStats waitTime;  // us, UI waiting for previous frame to be pushed
+	uint32_t lastFlushPixelsCount = 0;
+	std::atomic<bool> resetRequested = false; // by the UI, done by the display task at next frame
+
+	FrameBuffer() : GFXcanvas16(screenWidth, screenHeight) {}
+
+	/// Takes over the display SPI bus (releasing it from Arduino `SPIClass`
+	/// used for the initialization) and starts the display task.
+	void begin(ST7735Panel& panel, SPIClass& spi, int8_t sclk, int8_t mosi, int8_t cs, int8_t dc, uint32_t frequency)
+	{
+		xOffset = panel.xOffset();
+		yOffset = panel.yOffset();
+		dcPin = dc;
+		spi.end();
+
+		spi_bus_config_t bus {};
+		bus.mosi_io_num = mosi;
+		bus.miso_io_num = -1;
+		bus.sclk_io_num = sclk;
+		bus.quadwp_io_num = -1;
+		bus.quadhd_io_num = -1;
+		bus.max_transfer_sz = bandBytesCount;
+		ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO));
+
+		spi_device_interface_config_t device {};
+		device.mode = 0;
+		device.clock_speed_hz = frequency;
+		device.spics_io_num = cs;
+		device.queue_size = 2;
+		ESP_ERROR_CHECK(spi_bus_add_device(SPI2_HOST, &device, &spiDevice));
+		pinMode(dcPin, OUTPUT);
+
+		pending = static_cast<uint16_t*>(heap_caps_malloc(bytesCount, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+		shown = static_cast<uint16_t*>(heap_caps_malloc(bytesCount, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+		for (auto& band : bands) {
+			band = static_cast<uint16_t*>(heap_caps_malloc(bandBytesCount, MALLOC_CAP_DMA));
+		}
+		forceFull = true;
+
+		idle = xSemaphoreCreateBinary();
+		xSemaphoreGive(idle);
+		xTaskCreatePinnedToCore(taskMain, "display", taskStackSize, this, taskPriority, &task, taskCore);
+	}
+
+	/// Hands the rendered frame over to the display task. Waits only if the
+	/// previous frame is still being pushed. Rendering can continue right away,
+	/// on top of current content.
+	void flush()
+	{
+		const unsigned long start = micros();
+		xSemaphoreTake(idle, portMAX_DELAY);
+		waitTime.add(micros() - start);
+		memcpy(pending, getBuffer(), bytesCount);
+		xTaskNotifyGive(task);
+	}
+
+	/// Statistics reset from the UI, done by the display task before pushing
+	/// next frame (it adds to them, preempting the UI at any point).
+	inline void requestResetStats() { resetRequested = true; }
+
+private:
+	spi_device_handle_t spiDevice;
+	int8_t dcPin;
+	int16_t xOffset;
+	int16_t yOffset;
+
+	TaskHandle_t task;
+	SemaphoreHandle_t idle; // given when display task is ready for next frame
+	uint16_t* pending; // frame to be pushed
+	uint16_t* shown;   // what is on the display
+	uint16_t* bands[2]; // DMA capable, byte-swapped, to prepare one while other is sent
+	spi_transaction_t transaction;
+	bool forceFull;
+
+	struct Rect { int16_t x, y, w, h; };
+
+	static void taskMain(void* param)
+	{
+		auto& self = *static_cast<FrameBuffer*>(param);
+		while (true) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			if (self.resetRequested.exchange(false)) {
+				self.flushTime.reset();
+				self.waitTime.reset();
+			}
+			const unsigned long start = micros();
+			self.pushChanges();
+			self.flushTime.add(micros() - start);
+			xSemaphoreGive(self.idle);
+		}
+	}
+
+	/// Finds bounding rectangle of changed pixels within the band.
+	bool findChanges(int16_t bandY, Rect& rect)
+	{
+		int16_t minX = screenWidth, maxX = -1, minY = screenHeight, maxY = -1;
+		for (int16_t y = bandY; y < bandY + bandHeight; y++) {
+			const uint16_t* a = pending + y * screenWidth;
+			const uint16_t* b = shown + y * screenWidth;
+			if (!forceFull && memcmp(a, b, screenWidth * sizeof(uint16_t)) == 0)
+				continue;
+			int16_t left = 0, right = screenWidth - 1;
+			if (!forceFull) {
+				while (a[left] == b[left]) left++;
+				while (a[right] == b[right]) right--;
+			}
+			if (left < minX) minX = left;
+			if (right > maxX) maxX = right;
+			if (y < minY) minY = y;
+			maxY = y;
+		}
+		if (maxY < 0)
+			return false;
+		rect = { minX, minY, static_cast<int16_t>(maxX - minX + 1), static_cast<int16_t>(maxY - minY + 1) };
+		return true;
+	}
+
+	void sendCommand(uint8_t command, uint16_t a, uint16_t b)
+	{
+		spi_transaction_t t {};
+		t.flags = SPI_TRANS_USE_TXDATA;
+		t.length = 8;
+		t.tx_data[0] = command;
+		digitalWrite(dcPin, LOW);
+		spi_device_polling_transmit(spiDevice, &t);
+		t.length = 32;
+		t.tx_data[0] = a >> 8;
+		t.tx_data[1] = a & 0xFF;
+		t.tx_data[2] = b >> 8;
+		t.tx_data[3] = b & 0xFF;
+		digitalWrite(dcPin, HIGH);
+		spi_device_polling_transmit(spiDevice, &t);
+	}
+
+	void pushChanges()
+	{
+		lastFlushPixelsCount = 0;
+		bool inFlight = false;
+		uint8_t current = 0;
+		for (int16_t bandY = 0; bandY < screenHeight; bandY += bandHeight) {
+			Rect r;
+			if (!findChanges(bandY, r))
+				continue;
+
+			// Prepare the pixels (display expects big-endian) and remember them as shown
+			uint16_t* out = bands[current];
+			for (int16_t y = r.y; y < r.y + r.h; y++) {
+				const uint16_t* in = pending + y * screenWidth + r.x;
+				for (int16_t x = 0; x < r.w; x++) {
+					*out++ = __builtin_bswap16(in[x]);
+				}
+				memcpy(shown + y * screenWidth + r.x, in, r.w * sizeof(uint16_t));
+			}
+			const size_t pixelsCount = r.w * r.h;
+			lastFlushPixelsCount += pixelsCount;
+
+			// Previous band must be sent before switching the window
+			if (inFlight) {
+				spi_transaction_t* done;
+				spi_device_get_trans_result(spiDevice, &done, portMAX_DELAY);
+			}
+			sendCommand(0x2A /* CASET */, xOffset + r.x, xOffset + r.x + r.w - 1);
+			sendCommand(0x2B /* RASET */, yOffset + r.y, yOffset + r.y + r.h - 1);
+			spi_transaction_t t {};
+			t.flags = SPI_TRANS_USE_TXDATA;
+			t.length = 8;
+			t.tx_data[0] = 0x2C; /* RAMWR */
+			digitalWrite(dcPin, LOW);
+			spi_device_polling_transmit(spiDevice, &t);
+			digitalWrite(dcPin, HIGH);
+
+			transaction = {};
+			transaction.length = pixelsCount * 16;
+			transaction.tx_buffer = bands[current];
+			spi_device_queue_trans(spiDevice, &transaction, portMAX_DELAY);
+			inFlight = true;
+			current ^= 1;
+		}
+		if (inFlight) {
+			spi_transaction_t* done;
+			spi_device_get_trans_result(spiDevice, &done, portMAX_DELAY);
+		}
+		forceFull = false;
+	}
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <stdarg.h>
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "timing_stats.hpp"
+
+/// Glyphs of GFX font pre-rendered (once) into RGB565 bitmaps in given colors,
+/// for selected characters (like digits, sign, dot & units), so strings are
+/// blitted into the canvas with row copies, instead of clearing the area and
+/// drawing the glyphs pixel by pixel. Each cell is as wide as the advance of
+/// its character and as high as the tallest of the selected ones, and covers
+/// it with the background, so new string fully replaces previous one.
+class GlyphCache
+{
+public:
+	static constexpr char firstCharacter = ' ';
+	static constexpr char lastCharacter = '~';
+
+	static inline TimingStats drawTime; // CPU cycles, of single string (for all the caches)
+
+	/// Renders the glyphs of given characters. Others (if in the font) are drawn as background.
+	void begin(const GFXfont& font, const char* characters, uint16_t color, uint16_t background)
+	{
+		this->background = background;
+
+		// Vertical extent of the cells, relative to the baseline
+		int16_t bottom = 0;
+		top = 0;
+		uint32_t pixelsCount = 0;
+		for (const char* c = characters; *c; c++) {
+			const GFXglyph* glyph = findGlyph(font, *c);
+			if (!glyph) continue;
+			if (glyph->yOffset < top) top = glyph->yOffset;
+			if (glyph->yOffset + glyph->height > bottom) bottom = glyph->yOffset + glyph->height;
+		}
+		height = bottom - top;
+
+		for (char c = firstCharacter; c <= lastCharacter; c++) {
+			const GFXglyph* glyph = findGlyph(font, c);
+			cells[c - firstCharacter].width = glyph ? glyph->xAdvance : 0;
+			if (glyph && strchr(characters, c)) pixelsCount += glyph->xAdvance * height;
+		}
+
+		// Render the selected ones, clipped to their cells
+		pixels = new uint16_t[pixelsCount];
+		uint16_t* next = pixels;
+		for (char c = firstCharacter; c <= lastCharacter; c++) {
+			const GFXglyph* glyph = findGlyph(font, c);
+			if (!glyph || !strchr(characters, c)) continue;
+			auto& cell = cells[c - firstCharacter];
+			cell.pixels = next;
+			next += cell.width * height;
+			for (uint16_t i = 0; i < cell.width * height; i++) cell.pixels[i] = background;
+			const uint8_t* bitmap = font.bitmap + glyph->bitmapOffset;
+			uint16_t bit = 0;
+			for (int16_t gy = 0; gy < glyph->height; gy++) {
+				for (int16_t gx = 0; gx < glyph->width; gx++, bit++) {
+					if (!(bitmap[bit / 8] & (0x80 >> (bit % 8)))) continue;
+					const int16_t x = glyph->xOffset + gx;
+					const int16_t y = glyph->yOffset + gy - top;
+					if (0 <= x && x < cell.width) cell.pixels[y * cell.width + x] = color;
+				}
+			}
+		}
+	}
+
+	/// Draws the text with baseline at given position (like GFX with custom font),
+	/// padding it with the background up to given width. Returns width of the text.
+	/// Canvas must be without rotation.
+	int16_t draw(GFXcanvas16& canvas, int16_t x, int16_t y, int16_t boxWidth, const char* text)
+	{
+		const uint32_t start = ESP.getCycleCount();
+		int16_t cursor = x;
+		for (const char* c = text; *c; c++) {
+			if (*c < firstCharacter || lastCharacter < *c) continue;
+			const auto& cell = cells[*c - firstCharacter];
+			blit(canvas, cursor, y + top, cell.width, cell.pixels);
+			cursor += cell.width;
+		}
+		if (cursor < x + boxWidth) {
+			blit(canvas, cursor, y + top, x + boxWidth - cursor, nullptr);
+		}
+		drawTime.add(ESP.getCycleCount() - start);
+		return cursor - x;
+	}
+
+	int16_t drawf(GFXcanvas16& canvas, int16_t x, int16_t y, int16_t boxWidth, const char* format, ...)
+		__attribute__((format(printf, 6, 7)))
+	{
+		char text[24];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(text, sizeof(text), format, args);
+		va_end(args);
+		return draw(canvas, x, y, boxWidth, text);
+	}
+
+private:
+	struct Cell
+	{
+		uint16_t* pixels = nullptr; // `width` by `height`, null if not rendered (drawn as background)
+		uint8_t width = 0;
+	};
+
+	Cell cells[lastCharacter - firstCharacter + 1];
+	uint16_t* pixels = nullptr; // all the cells
+	int16_t top = 0; // of the cells, relative to the baseline
+	int16_t height = 0;
+	uint16_t background = 0;
+
+	static const GFXglyph* findGlyph(const GFXfont& font, char c)
+	{
+		if (c < font.first || font.last < c)
+			return nullptr;
+		return font.glyph + (c - font.first);
+	}
+
+	/// Copies the cell rows (or fills with the background), clipped to the canvas.
+	void blit(GFXcanvas16& canvas, int16_t x, int16_t y, int16_t width, const uint16_t* source)
+	{
+		const int16_t left = max<int16_t>(x, 0);
+		const int16_t right = min<int16_t>(x + width, canvas.width());
+		const int16_t topRow = max<int16_t>(y, 0);
+		const int16_t bottomRow = min<int16_t>(y + height, canvas.height());
+		if (left >= right) return;
+		uint16_t* buffer = canvas.getBuffer();
+		for (int16_t row = topRow; row < bottomRow; row++) {
+			uint16_t* out = buffer + row * canvas.width() + left;
+			if (source) {
+				memcpy(out, source + (row - y) * width + (left - x), (right - left) * sizeof(uint16_t));
+			}
+			else {
+				for (int16_t i = 0; i < right - left; i++) out[i] = background;
+			}
+		}
+	}
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+/// Histogram of latencies with linear buckets, fine enough for percentiles
+/// of the milliseconds (unlike power-of-two buckets of `TimingStats`).
+/// Single writer; readers might see slightly torn values, which is fine for
+/// displaying.
+struct LatencyHistogram
+{
+	static constexpr uint16_t bucketWidth = 250; // us
+	static constexpr uint8_t bucketsCount = 200; // up to 50 ms, last one takes the longer too
+
+	uint32_t count = 0;
+	uint32_t max = 0; // us
+	uint64_t sum = 0; // us
+	uint32_t buckets[bucketsCount] = {}; // bucket `i` holds values in range [i * width, (i + 1) * width)
+
+	constexpr void reset()
+	{
+		*this = LatencyHistogram();
+	}
+
+	constexpr void add(uint32_t us)
+	{
+		const uint32_t i = us / bucketWidth;
+		count += 1;
+		sum += us;
+		if (us > max) max = us;
+		buckets[i < bucketsCount ? i : bucketsCount - 1] += 1;
+	}
+
+	constexpr uint32_t average() const
+	{
+		return count ? sum / count : 0;
+	}
+
+	/// Returns value (rounded up to bucket bound) below which given percent
+	/// of the samples are, limited by the actual max value.
+	constexpr uint32_t percentile(uint8_t percent) const
+	{
+		if (count == 0) return 0;
+		const uint64_t threshold = (static_cast<uint64_t>(count) * percent + 99) / 100;
+		uint64_t accumulated = 0;
+		for (uint8_t i = 0; i < bucketsCount; i++) {
+			accumulated += buckets[i];
+			if (accumulated >= threshold) {
+				if (i == bucketsCount - 1) break; // the longer ones
+				const uint32_t bound = (i + 1ul) * bucketWidth - 1;
+				return bound < max ? bound : max;
+			}
+		}
+		return max;
+	}
+};
+
+/// Latency mode measurements, done by the radio task: control frames are
+/// stamped with the time of sampling the controls, and the receiver echoes
+/// the stamp of the frame taken by its outputs, with the delay since the
+/// frame reception (see `LatencyEchoPacket`). The clocks of both sides are
+/// not related, so:
+/// + round trip - from sampling the controls to the echo coming back (through
+///   the outputs latch & next ACK payload of the echo), on transmitter clock;
+/// + one way - stick to servo: from sampling to the write, the packet on air
+///   (estimated from the link profile) & the receiver delay up to the latch.
+struct LatencyMeter
+{
+	LatencyHistogram roundTrip;
+	LatencyHistogram oneWay;
+	uint32_t unmatchedCount = 0; // echoes of frames no longer remembered (or corrupted)
+
+	/// Remembers stamped frame, with the time (us) from the stamp to the
+	/// packet reception: processing & waiting for the write, and the transmission.
+	constexpr void onSent(uint8_t sequence, uint32_t stamp, uint32_t toReception)
+	{
+		auto& frame = sent[sequence & controlSequenceMask];
+		frame.stamp = stamp;
+		frame.toReception = toReception;
+	}
+
+	/// Takes echo returned at given time (us).
+	constexpr bool onEcho(const LatencyEchoPacket& echo, uint32_t now)
+	{
+		const auto& frame = sent[echo.sequence & controlSequenceMask];
+		if (frame.stamp != echo.stamp) {
+			unmatchedCount += 1;
+			return false;
+		}
+		roundTrip.add(now - echo.stamp);
+		oneWay.add(frame.toReception + echo.latchDelay);
+		return true;
+	}
+
+	constexpr void reset()
+	{
+		roundTrip.reset();
+		oneWay.reset();
+		unmatchedCount = 0;
+	}
+
+	/// Prints the statistics & histograms (non-empty buckets) as text tables.
+	template <typename Output>
+	void dump(Output& output) const
+	{
+		const LatencyHistogram* histograms[] = { &oneWay, &roundTrip };
+		const char* names[] = { "one-way", "round-trip" };
+		output.printf("latency      count  avg[us]  p50[us]  p95[us]  p99[us]  max[us]\n");
+		for (uint8_t i = 0; i < 2; i++) {
+			const auto& h = *histograms[i];
+			output.printf("%-10s %7lu %8lu %8lu %8lu %8lu %8lu\n", names[i], static_cast<unsigned long>(h.count),
+				static_cast<unsigned long>(h.average()), static_cast<unsigned long>(h.percentile(50)),
+				static_cast<unsigned long>(h.percentile(95)), static_cast<unsigned long>(h.percentile(99)),
+				static_cast<unsigned long>(h.max));
+		}
+		output.printf("unmatched %lu\n", static_cast<unsigned long>(unmatchedCount));
+		output.printf("from[us]  one-way  round-trip\n");
+		for (uint8_t i = 0; i < LatencyHistogram::bucketsCount; i++) {
+			if (!oneWay.buckets[i] && !roundTrip.buckets[i]) continue;
+			output.printf("%8lu %8lu %11lu\n", static_cast<unsigned long>(i) * LatencyHistogram::bucketWidth,
+				static_cast<unsigned long>(oneWay.buckets[i]), static_cast<unsigned long>(roundTrip.buckets[i]));
+		}
+	}
+
+private:
+	struct SentFrame
+	{
+		uint32_t stamp;
+		uint32_t toReception; // us
+	};
+	SentFrame sent[controlSequenceMask + 1] = {}; // by the sequence number
+};
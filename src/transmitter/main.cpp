@@ -1,4 +1,5 @@
 #include <tuple>
+#include <atomic>
 #include <SPI.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7735.h>
@@ -9,6 +10,22 @@
 #include <EEPROM.h>
 #include <rom/crc.h>
 #include "common/packets.hpp"
+#include "common/hopping.hpp"
+#include "common/link_profiles.hpp"
+#include "snapshot.hpp"
+#include "double_buffer.hpp"
+#include "frame_scheduler.hpp"
+#include "framebuffer.hpp"
+#include "glyph_cache.hpp"
+#include "widgets.hpp"
+#include "analog_sampler.hpp"
+#include "calibration.hpp"
+#include "mixer.hpp"
+#include "latency_meter.hpp"
+#include "transmitter_link.hpp"
+#include "spectrum.hpp"
+#include "profiler.hpp"
+#include "settings_store.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Hardware
@@ -23,7 +40,20 @@ SPIClass radio_spi(HSPI);
 #define TFT_DC   37
 #define TFT_RST  38
 
-Adafruit_ST7735 tft(&tft_spi, TFT_CS, TFT_DC, TFT_RST);
+ST7735Panel tft(&tft_spi, TFT_CS, TFT_DC, TFT_RST);
+FrameBuffer screen; // pages render here, changes are pushed to the display in background
+
+// Values changing every loop (on Info & Centered pages) are blitted from pre-rendered glyphs.
+// Same characters for all the large ones, so their cells are of the same height.
+constexpr const char* largeGlyphsCharacters = "0123456789-.%Vbrak!";
+GlyphCache largeGlyphs; // FreeSans12pt7b, white
+GlyphCache largeGoodGlyphs; // green
+GlyphCache largeFairGlyphs; // yellow
+GlyphCache largeBadGlyphs; // red
+GlyphCache mediumGlyphs; // FreeSans9pt7b, white
+// Names on the Reverse page (channel & state), as fields in other than the default font are blitted too
+constexpr const char* mediumNamesCharacters = "ACERTadehilmnorstuvwy5<> ";
+GlyphCache mediumNamesGlyphs; // FreeSans9pt7b, white
 
 #define RF24_SCLK 12
 #define RF24_MISO 13
@@ -35,7 +65,6 @@ Adafruit_ST7735 tft(&tft_spi, TFT_CS, TFT_DC, TFT_RST);
 RF24 radio(RF24_CE, RF24_CSN);
 
 const uint8_t transmitterOutputAddress[6] = "ctrl!";
-const uint8_t transmitterInputAddress[6]  = "info?";
 
 #define F1_PIN          21
 #define BUZZER_PIN      47
@@ -50,43 +79,67 @@ const uint8_t transmitterInputAddress[6]  = "info?";
 #define AUX_2_PIN       44
 #define AUX_3_PIN       42
 
+/// Analog inputs sampled in background, first ones match `AnalogChannel`.
+const AnalogInputConfig analogInputs[] = {
+	{ THROTTLE_PIN,  AnalogFilter::LowPass, 2 },
+	{ RUDDER_PIN,    AnalogFilter::LowPass, 2 },
+	{ ELEVATOR_PIN,  AnalogFilter::LowPass, 2 },
+	{ AILERON_PIN,   AnalogFilter::LowPass, 2 },
+	{ CHANNEL_5_PIN, AnalogFilter::Median,  0 },
+	{ TRANSMITTER_BATTERY_PIN, AnalogFilter::LowPass, 6 },
+};
+constexpr uint8_t transmitterBatteryInputIndex = 5;
+AnalogSampler analogSampler;
+
 const char* channelNames[] = {
 	"Throttle", "Rudder", "Elevator", "Aileron", "Channel 5", 
 	"Aux 1", "Aux 2", "Aux 3",
 };
 
+const char* linkProfileNames[] = {
+	"Zasieg", "Standard", "Szybki", "Wyscig",
+};
+static_assert(sizeof(linkProfileNames) / sizeof(linkProfileNames[0]) == linkProfilesCount);
+
+const char* mixPresetNames[] = {
+	"brak", "Elevon", "V-tail", "Flaperon", "wlasny",
+};
+static_assert(sizeof(mixPresetNames) / sizeof(mixPresetNames[0]) == static_cast<uint8_t>(MixPreset::Custom) + 1);
+
+void setRadioProfile(const LinkProfile& profile)
+{
+	radio.setDataRate(static_cast<rf24_datarate_e>(profile.dataRate));
+	radio.setCRCLength(static_cast<rf24_crclength_e>(profile.crcLength));
+	radio.setRetries(profile.retryDelay, 0); // no retries, just waiting for the ACK with status payload
+}
+static_assert(RF24_1MBPS == 0 && RF24_2MBPS == 1 && RF24_250KBPS == 2);
+static_assert(RF24_CRC_8 == 1 && RF24_CRC_16 == 2);
+
 ////////////////////////////////////////////////////////////////////////////////
-// Saved state (in EEPROM)
+// Saved state (in NVS, see `settingsRecords`)
 
 struct Settings
 {
-	static constexpr uint32_t currentVersion = 2;
+	static constexpr uint32_t storeVersion = 1; // of the records layout in the store
 
 	////////////////////////////////////////
-	// 0x000 - 0x010: Header
+	// 0x000 - 0x010: Header (of the blob saved in EEPROM by older versions, for the migration)
 
 	uint8_t _emptyBeginPad[8];
 	uint32_t version;
 	uint32_t checksum;
 
-	uint32_t calculateChecksum()
+	uint32_t calculateChecksum(uint16_t length)
 	{
 		constexpr uint16_t prefixLength = offsetof(Settings, checksum) + sizeof(checksum);
-		return crc32_le(0, reinterpret_cast<uint8_t*>(this) + prefixLength, sizeof(Settings) - prefixLength);
+		return crc32_le(0, reinterpret_cast<uint8_t*>(this) + prefixLength, length - prefixLength);
 	}
 
-	bool validate()
+	/// Checks the blob saved in EEPROM by older versions: 2 (calibration only) or 3 (with the link).
+	bool validateLegacy()
 	{
-		return checksum == calculateChecksum() && version == currentVersion;
-	}
-
-	bool prepareForSave()
-	{
-		uint32_t calculatedChecksum = calculateChecksum();
-		bool changed = checksum != calculatedChecksum;
-		version = currentVersion;
-		checksum = calculatedChecksum;
-		return changed;
+		const uint16_t length = version == 2 ? offsetof(Settings, linkProfile) : version == 3 ? offsetof(Settings, mixer) : 0;
+		return length && checksum == calculateChecksum(length);
 	}
 
 	////////////////////////////////////////
@@ -102,6 +155,18 @@ struct Settings
 	};
 	uint8_t _padAfterCalibration[8];
 
+	////////////////////////////////////////
+	// 0x060 - 0x070: Link
+
+	uint8_t linkProfile = defaultLinkProfile; // index in `linkProfiles`
+	uint8_t linkChannel = 0; // see `TransmitterRequest::LinkChannel`, 0 for the default
+	uint8_t _padAfterLink[14];
+
+	////////////////////////////////////////
+	// 0x070 - 0x0B0: Mixer (curves, trims & mix lines, see `mixer.hpp`)
+
+	MixerSettings mixer;
+
 	////////////////////////////////////////
 
 	void resetToDefault() {
@@ -110,8 +175,28 @@ struct Settings
 };
 static_assert(offsetof(Settings, calibration) == 0x10);
 static_assert(sizeof(Settings::calibration) <= 0x50);
+static_assert(offsetof(Settings, linkProfile) == 0x60);
+static_assert(offsetof(Settings, mixer) == 0x70);
+
+/// Saved separately, so changing single channel calibration writes only its record.
+const SettingsRecord settingsRecords[] = {
+	{ "calibration0", offsetof(Settings, calibration[0]), sizeof(AnalogChannelCalibrationData) },
+	{ "calibration1", offsetof(Settings, calibration[1]), sizeof(AnalogChannelCalibrationData) },
+	{ "calibration2", offsetof(Settings, calibration[2]), sizeof(AnalogChannelCalibrationData) },
+	{ "calibration3", offsetof(Settings, calibration[3]), sizeof(AnalogChannelCalibrationData) },
+	{ "calibration4", offsetof(Settings, calibration[4]), sizeof(AnalogChannelCalibrationData) },
+	{ "calibration5", offsetof(Settings, calibration[5]), sizeof(AnalogChannelCalibrationData) },
+	{ "linkProfile",  offsetof(Settings, linkProfile), sizeof(Settings::linkProfile) },
+	{ "linkChannel",  offsetof(Settings, linkChannel), sizeof(Settings::linkChannel) },
+	{ "mixerInput0",  offsetof(Settings, mixer.inputs[0]), sizeof(MixerInputSettings) },
+	{ "mixerInput1",  offsetof(Settings, mixer.inputs[1]), sizeof(MixerInputSettings) },
+	{ "mixerInput2",  offsetof(Settings, mixer.inputs[2]), sizeof(MixerInputSettings) },
+	{ "mixerInput3",  offsetof(Settings, mixer.inputs[3]), sizeof(MixerInputSettings) },
+	{ "mixerInput4",  offsetof(Settings, mixer.inputs[4]), sizeof(MixerInputSettings) },
+	{ "mixerLines",   offsetof(Settings, mixer.lines), sizeof(MixerSettings::lines) },
+};
 
-Settings* settings;
+Settings settings;
 
 ////////////////////////////////////////////////////////////////////////////////
 // State
@@ -126,10 +211,24 @@ enum class Page : unsigned int
 	Calibrate,  // Setup analog min/center/max reference values on each control,
                 // microseconds min/center/max for the servos for the receiver.
 	Reverse,    // Allow reversing of the channels.
+	Mixer,      // Expo, dual rates & trims of the inputs, mixes (like elevon).
+	Timing,     // Control frames rate selection, jitter & loop time statistics.
+	Render,     // Pages render & display flush time statistics.
+	Link,       // Link quality details: loss, gaps, jitter, acknowledgements.
+	Profile,    // Per-stage CPU time of the radio task & the UI loop.
+	Latency,    // Latency mode switch, stick-to-servo & round trip latency percentiles.
+	Spectrum,   // Activity on the RF channels, choice of the link channel.
 	Count,      // Not a page, count of all the pages.
 };
 Page page = Page::Info;
 
+const char* pageNames[] = {
+	"Info", "Raw", "Centered", "Calibrate", "Reverse", "Mixer", "Timing", "Render", "Link", "Profile", "Latency", "Spectrum",
+};
+static_assert(sizeof(pageNames) / sizeof(pageNames[0]) == static_cast<unsigned int>(Page::Count));
+
+TimingStats pageRenderTimes[static_cast<unsigned int>(Page::Count)]; // us
+
 bool isPageAdvancedModeOnly(Page page)
 {
 	switch (page)
@@ -137,6 +236,7 @@ bool isPageAdvancedModeOnly(Page page)
 		case Page::Info:
 		case Page::Centered:
 		case Page::Reverse:
+		case Page::Mixer:
 			return false;
 		default:
 			return true;
@@ -155,24 +255,348 @@ void goNextPage()
 
 unsigned long f1ButtonPressed = 0; // 0 means not pressed
 constexpr unsigned long longPressDuration = 777; // ms
+
+constexpr unsigned int rxSignalLostDuration = 1024; // ms
+
+/// Link profile selected by the user (radio task switches to it, along with the receiver,
+/// once handed over by `compileSettings`).
+uint8_t selectedLinkProfile()
+{
+	return settings.linkProfile < linkProfilesCount ? settings.linkProfile : defaultLinkProfile;
+}
+
+/// Link channel selected by the user (radio task switches to it, along with the receiver,
+/// once handed over by `compileSettings`).
+uint8_t selectedLinkChannel()
+{
+	return isLinkChannelValid(settings.linkChannel) ? settings.linkChannel : 0;
+}
+
+/// State published by the radio task after each control frame, for the UI.
+struct RadioState
+{
+	uint16_t rawAnalogValues[6];
+	uint16_t mappedValues[6];
+	uint16_t txBatteryRaw;
+	TransmitterLinkState link;
+};
+Snapshot<RadioState> radioState;
+
+DoubleBuffer<CompiledCalibration> compiledCalibration; // compiled by the UI from the settings, taken by the radio task
+DoubleBuffer<CompiledMixer> compiledMixer; // compiled by the UI from the settings, taken by the radio task
+
+TransmitterLink<RF24> transmitterLink(radio, defaultLinkProfile); // owned by the radio task
+std::atomic<uint8_t> publishedLinkProfile = defaultLinkProfile; // selected one, handed over by the UI with the settings
+std::atomic<uint8_t> publishedLinkChannel = 0; // selected one, handed over by the UI with the settings
+
+std::atomic<bool> latencyMode = false; // control frames stamped for the latency measurements (set by the UI)
+LatencyMeter& latencyMeter = transmitterLink.latencyMeter; // written by the radio task
+std::atomic<bool> latencyResetRequested = false; // by the UI, done by the radio task
+
+std::atomic<bool> spectrumScan = false; // sweeps in spare time of the radio task, while the page is shown (set by the UI)
+Spectrum spectrum; // owned by the radio task
+TimingStats spectrumScanTime; // us, per control frame
+
+/// Spectrum published by the radio task after each scan, for the UI.
+struct SpectrumState
+{
+	Spectrum spectrum;
+	uint32_t scanTimeAverage; // us, per control frame
+};
+Snapshot<SpectrumState> spectrumState;
+std::atomic<bool> spectrumResetRequested = false; // by the UI, done by the radio task
+
+// Arduino `loop()` runs on `ARDUINO_RUNNING_CORE` (1), so the radio gets the other one.
+constexpr BaseType_t radioTaskCore = 0;
+constexpr UBaseType_t radioTaskPriority = 5;
+constexpr uint32_t radioTaskStackSize = 4096;
+void radioTask(void*);
+void compileSettings();
+
+// Copies of the radio state, as seen by the UI (refreshed every `loop()`)
 uint16_t rawAnalogValues[6];
 uint16_t mappedValues[6];
-
-TransmitterSignal txSignal;
+uint16_t txBatteryRaw;
+ControlFrame controlFrame;
 ReceiverSignal rxSignal;
-
-unsigned long lastTxSignalTime = 0;
 unsigned long lastRxSignalTime = 0;
-constexpr unsigned int rxSignalFetchInterval = 512; // ms
-constexpr unsigned int rxSignalListenDuration = 20; // ms
-constexpr unsigned int rxSignalLostDuration = 1024; // ms
-unsigned long lastRxSignalLastLatency = 0;
+unsigned long timeSinceLastRxSignal = 0;
+uint32_t sentCount = 0;
+uint32_t ackedCount = 0;
+uint8_t linkProfile = defaultLinkProfile;
+uint8_t linkChannel = 0;
+HopSequence linkHops = hopSequence; // of the link channel, updated along
+LinkProfileStats linkProfileStats[linkProfilesCount];
 
 unsigned long cooldownTime = 0; // for various things
 AnalogChannel selectedChannel;
 int8_t parameterSelected;
 int16_t extraBias;
 
+// Spectrum page columns as drawn (heights of the level & the peak), so only changed ones are redrawn
+uint8_t spectrumDrawnLevels[Spectrum::channelsCount];
+uint8_t spectrumDrawnPeaks[Spectrum::channelsCount];
+bool spectrumDrawn = false; // since the page was shown (on cleared screen)
+
+/// Whenever the link uses given RF channel.
+bool isLinkChannel(uint8_t channel)
+{
+#if LINK_FHSS
+	for (uint8_t i = 0; i < hopChannelsCount; i++) {
+		if (linkHops[i] == channel) return true;
+	}
+	return false;
+#else
+	return channel == fixedLinkChannel(linkChannel);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pages widgets (for the pages declared as widget tables, others draw themselves)
+
+// Transmitter battery uses 15V to 3.235V divider (12kOhm & 3.3kOhm),
+// ESP32S3 has 12-bit ADC.
+constexpr float txBatteryFactor = 3.235 / 4095.0 * (12000.0 + 3300.0) / 3300.0;
+
+constexpr uint16_t markColor = 0x7BEF; // gray
+
+WidgetRenderer widgetRenderer;
+
+GlyphCache* largeGlyphsFor(uint16_t color)
+{
+	switch (color) {
+		case ST77XX_GREEN:  return &largeGoodGlyphs;
+		case ST77XX_YELLOW: return &largeFairGlyphs;
+		case ST77XX_RED:    return &largeBadGlyphs;
+		default:            return &largeGlyphs;
+	}
+}
+
+GlyphCache* mediumGlyphsFor(uint16_t)
+{
+	return &mediumGlyphs;
+}
+
+GlyphCache* mediumNamesGlyphsFor(uint16_t)
+{
+	return &mediumNamesGlyphs;
+}
+
+template <typename... Args>
+void formatWidgetText(WidgetText& out, uint16_t color, const char* format, Args... args)
+{
+	snprintf(out.text, sizeof(out.text), format, args...);
+	out.color = color;
+}
+
+const Widget infoWidgets[] = {
+	{ .type = WidgetType::Label, .x = 0, .y = 20, .font = &FreeSans9pt7b, .text = "Nadajnik:" },
+	{ .type = WidgetType::Label, .x = 0, .y = 40, .font = &FreeSans9pt7b, .text = "Odbiornik:" },
+	{ .type = WidgetType::Label, .x = 0, .y = 60, .font = &FreeSans9pt7b, .text = "Sygnal:" },
+	// Values replace previous ones, up to the screen edge
+	{ .type = WidgetType::Field, .x = 96, .y = 20, .w = 160 - 96,
+		.format = [](WidgetText& out) {
+			formatWidgetText(out, ST77XX_WHITE, "%.2fV", txBatteryFactor * txBatteryRaw); // TODO: show only 1 digit after dot, if >10V
+		},
+		.glyphs = largeGlyphsFor, .interval = 500 },
+	{ .type = WidgetType::Field, .x = 96, .y = 40, .w = 160 - 96,
+		.format = [](WidgetText& out) {
+			const uint16_t mv = rxSignal.statusPacket.battery;
+			formatWidgetText(out, ST77XX_WHITE, "%u.%02uV", mv / 1000, mv % 1000 / 10);
+		},
+		.glyphs = largeGlyphsFor },
+	{ .type = WidgetType::Field, .x = 96, .y = 60, .w = 160 - 96,
+		.format = [](WidgetText& out) {
+			if (timeSinceLastRxSignal < rxSignalLostDuration) /* good */ {
+				// Rating from the receiver: received frames, penalized by long gaps
+				const uint8_t rating = rxSignal.statusPacket.signalRating;
+				formatWidgetText(out, rating >= 90 ? ST77XX_GREEN : rating >= 70 ? ST77XX_YELLOW : ST77XX_RED, "%hhu%%", rating);
+			}
+			else /* signal lost, bad */ {
+				formatWidgetText(out, ST77XX_RED, "brak!");
+			}
+		},
+		.glyphs = largeGlyphsFor },
+};
+
+const char* rawValueNames[] = { "throttle", "rudder", "elevator", "aileron", "channel5" };
+
+template <uint8_t i>
+void formatRawValue(WidgetText& out)
+{
+	formatWidgetText(out, ST77XX_WHITE, " %s=%hu", rawValueNames[i], rawAnalogValues[i]);
+}
+
+template <uint8_t i>
+int32_t rawValue()
+{
+	return rawAnalogValues[i];
+}
+
+template <uint8_t i>
+void formatRawAux(WidgetText& out)
+{
+	formatWidgetText(out, ST77XX_WHITE, " aux%u=%u", i + 1, controlFrame.aux(i));
+}
+
+const Widget rawWidgets[] = {
+	{ .type = WidgetType::Label, .x = 0, .y = 0, .color = ST77XX_WHITE, .text = "Surowe wartosci:" },
+	{ .type = WidgetType::Field, .x = 0, .y = 1 * 8, .w = 96, .format = formatRawValue<0>, .interval = 100 },
+	{ .type = WidgetType::Field, .x = 0, .y = 2 * 8, .w = 96, .format = formatRawValue<1>, .interval = 100 },
+	{ .type = WidgetType::Field, .x = 0, .y = 3 * 8, .w = 96, .format = formatRawValue<2>, .interval = 100 },
+	{ .type = WidgetType::Field, .x = 0, .y = 4 * 8, .w = 96, .format = formatRawValue<3>, .interval = 100 },
+	{ .type = WidgetType::Field, .x = 0, .y = 5 * 8, .w = 96, .format = formatRawValue<4>, .interval = 100 },
+	{ .type = WidgetType::Bar, .x = 100, .y = 1 * 8 + 1, .w = 56, .h = 6, .color = ST77XX_GREEN, .value = rawValue<0>, .range = 4095 },
+	{ .type = WidgetType::Bar, .x = 100, .y = 2 * 8 + 1, .w = 56, .h = 6, .color = ST77XX_GREEN, .value = rawValue<1>, .range = 4095 },
+	{ .type = WidgetType::Bar, .x = 100, .y = 3 * 8 + 1, .w = 56, .h = 6, .color = ST77XX_GREEN, .value = rawValue<2>, .range = 4095 },
+	{ .type = WidgetType::Bar, .x = 100, .y = 4 * 8 + 1, .w = 56, .h = 6, .color = ST77XX_GREEN, .value = rawValue<3>, .range = 4095 },
+	{ .type = WidgetType::Bar, .x = 100, .y = 5 * 8 + 1, .w = 56, .h = 6, .color = ST77XX_GREEN, .value = rawValue<4>, .range = 4095 },
+	{ .type = WidgetType::Field, .x = 0, .y = 6 * 8, .w = 96, .format = formatRawAux<0> },
+	{ .type = WidgetType::Field, .x = 0, .y = 7 * 8, .w = 96, .format = formatRawAux<1> },
+	{ .type = WidgetType::Field, .x = 0, .y = 8 * 8, .w = 96, .format = formatRawAux<2> },
+};
+
+template <uint8_t i>
+void formatCenteredValue(WidgetText& out)
+{
+	constexpr int div = 6; // losing some accuracy for easier displaying & reading
+	formatWidgetText(out, ST77XX_WHITE, "%hd", (controlFrame.channels[i] - settings.calibration[i].usCenter) / div);
+}
+
+constexpr int16_t centeredLabelsWidth = 42;
+const Widget centeredWidgets[] = {
+	{ .type = WidgetType::Label, .x = 0, .y = 0, .color = ST77XX_WHITE, .text = "Wartosci od srodka:" },
+	{ .type = WidgetType::Label, .x =  0, .y = 12 + 1 * 16, .font = &FreeSans9pt7b, .text = "THR:" },
+	{ .type = WidgetType::Label, .x =  0, .y = 12 + 2 * 16, .font = &FreeSans9pt7b, .text = "RUD:" },
+	{ .type = WidgetType::Label, .x = 80, .y = 12 + 1 * 16, .font = &FreeSans9pt7b, .text = "ELV:" },
+	{ .type = WidgetType::Label, .x = 80, .y = 12 + 2 * 16, .font = &FreeSans9pt7b, .text = "AIL:" },
+	{ .type = WidgetType::Label, .x =  0, .y = 12 + 3 * 16, .font = &FreeSans9pt7b, .text = "CH5:" },
+	{ .type = WidgetType::Field, .x =  0 + centeredLabelsWidth, .y = 12 + 1 * 16, .w = 80 - centeredLabelsWidth,
+		.format = formatCenteredValue<0>, .glyphs = mediumGlyphsFor },
+	{ .type = WidgetType::Field, .x =  0 + centeredLabelsWidth, .y = 12 + 2 * 16, .w = 80 - centeredLabelsWidth,
+		.format = formatCenteredValue<1>, .glyphs = mediumGlyphsFor },
+	{ .type = WidgetType::Field, .x = 80 + centeredLabelsWidth, .y = 12 + 1 * 16, .w = 80 - centeredLabelsWidth,
+		.format = formatCenteredValue<2>, .glyphs = mediumGlyphsFor },
+	{ .type = WidgetType::Field, .x = 80 + centeredLabelsWidth, .y = 12 + 2 * 16, .w = 80 - centeredLabelsWidth,
+		.format = formatCenteredValue<3>, .glyphs = mediumGlyphsFor },
+	{ .type = WidgetType::Field, .x =  0 + centeredLabelsWidth, .y = 12 + 3 * 16, .w = 80 - centeredLabelsWidth,
+		.format = formatCenteredValue<4>, .glyphs = mediumGlyphsFor },
+	{ .type = WidgetType::Field, .x = 6, .y = 80 - 12, .w = 154, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "AUX1: %u  AUX2: %u  AUX3: %u", controlFrame.aux(0), controlFrame.aux(1), controlFrame.aux(2));
+	}},
+};
+
+/// Calibration of the channel selected on the Calibrate (or Reverse) page.
+AnalogChannelCalibrationData& selectedCalibration()
+{
+	return settings.calibration[static_cast<int8_t>(selectedChannel)];
+}
+
+template <int8_t parameter>
+int32_t isParameterSelected()
+{
+	return parameterSelected == parameter;
+}
+
+constexpr int16_t calibrateChannelY = 12;
+constexpr int16_t calibrateCurrentsY = 24;
+constexpr int16_t calibrateValuesY = 40;
+const Widget calibrateWidgets[] = {
+	{ .type = WidgetType::Label, .x = 0, .y = 0, .color = ST77XX_WHITE, .text = "Kalibracja" },
+	// Current value (raw & mapped)
+	{ .type = WidgetType::Field, .x = 2, .y = calibrateCurrentsY, .w = 76, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "raw=%u", rawAnalogValues[static_cast<int8_t>(selectedChannel)]);
+	}, .interval = 100 },
+	{ .type = WidgetType::Field, .x = 82, .y = calibrateCurrentsY, .w = 76, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "us=%u", mappedValues[static_cast<int8_t>(selectedChannel)]);
+	}, .interval = 100 },
+	// Channel & the calibration values, marked when selected
+	{ .type = WidgetType::Label, .x = 12, .y = calibrateChannelY, .color = ST77XX_WHITE, .text = "Kanal:" },
+	{ .type = WidgetType::Field, .x = 12 + 42, .y = calibrateChannelY, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "%s", channelNames[static_cast<int8_t>(selectedChannel)]);
+	}},
+	{ .type = WidgetType::Field, .x = 2, .y = calibrateValuesY + 0 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "rawMin=%u", selectedCalibration().rawMin);
+	}},
+	{ .type = WidgetType::Field, .x = 2, .y = calibrateValuesY + 1 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "rawCtr=%u", selectedCalibration().rawCenter);
+	}},
+	{ .type = WidgetType::Field, .x = 2, .y = calibrateValuesY + 2 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "rawMax=%u", selectedCalibration().rawMax);
+	}},
+	{ .type = WidgetType::Field, .x = 82, .y = calibrateValuesY + 0 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "usMin=%u", selectedCalibration().usMin);
+	}},
+	{ .type = WidgetType::Field, .x = 82, .y = calibrateValuesY + 1 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "usCtr=%u", selectedCalibration().usCenter);
+	}},
+	{ .type = WidgetType::Field, .x = 82, .y = calibrateValuesY + 2 * 12, .w = 72, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "usMax=%u", selectedCalibration().usMax);
+	}},
+	{ .type = WidgetType::Marker, .x = 0, .y = calibrateValuesY - 2 + 0 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<0> },
+	{ .type = WidgetType::Marker, .x = 0, .y = calibrateValuesY - 2 + 1 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<1> },
+	{ .type = WidgetType::Marker, .x = 0, .y = calibrateValuesY - 2 + 2 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<2> },
+	{ .type = WidgetType::Marker, .x = 80, .y = calibrateValuesY - 2 + 0 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<3> },
+	{ .type = WidgetType::Marker, .x = 80, .y = calibrateValuesY - 2 + 1 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<4> },
+	{ .type = WidgetType::Marker, .x = 80, .y = calibrateValuesY - 2 + 2 * 12, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<5> },
+	{ .type = WidgetType::Marker, .x = 12 + 40, .y = calibrateChannelY - 2, .w = 76, .h = 12, .color = markColor, .value = isParameterSelected<6> },
+};
+
+/// Channel selected on the Reverse page is reversed by swapping its microseconds range.
+bool isSelectedChannelReversed()
+{
+	return selectedCalibration().usMin > selectedCalibration().usMax;
+}
+
+const Widget reverseWidgets[] = {
+	{ .type = WidgetType::Label, .x = 0, .y = 0, .color = ST77XX_WHITE, .text = "Odwracanie" },
+	{ .type = WidgetType::Label, .x = 8, .y = 24, .font = &FreeSans9pt7b, .text = "Kanal:" },
+	{ .type = WidgetType::Label, .x = 8, .y = 40, .font = &FreeSans9pt7b, .text = "Stan:" },
+	{ .type = WidgetType::Field, .x = 8 + 52, .y = 24, .w = 160 - 8 - 52, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "%s", channelNames[static_cast<int8_t>(selectedChannel)]);
+	}, .glyphs = mediumNamesGlyphsFor },
+	{ .type = WidgetType::Field, .x = 8 + 42, .y = 40, .w = 160 - 8 - 42, .format = [](WidgetText& out) {
+		formatWidgetText(out, ST77XX_WHITE, "%s", isSelectedChannelReversed() ? "rewers >" : "< normalny");
+	}, .glyphs = mediumNamesGlyphsFor },
+};
+
+struct PageWidgets
+{
+	const Widget* widgets;
+	uint8_t count;
+};
+
+template <size_t N>
+constexpr PageWidgets pageWidgetsOf(const Widget (&widgets)[N])
+{
+	static_assert(N <= WidgetRenderer::maxWidgetsCount);
+	return { widgets, N };
+}
+
+/// Widget tables of the pages (by `Page`), empty for the ones drawing themselves.
+const PageWidgets pagesWidgets[] = {
+	/* Info      */ pageWidgetsOf(infoWidgets),
+	/* Raw       */ pageWidgetsOf(rawWidgets),
+	/* Centered  */ pageWidgetsOf(centeredWidgets),
+	/* Calibrate */ pageWidgetsOf(calibrateWidgets),
+	/* Reverse   */ pageWidgetsOf(reverseWidgets),
+	/* Mixer     */ {},
+	/* Timing    */ {},
+	/* Render    */ {},
+	/* Link      */ {},
+	/* Profile   */ {},
+	/* Latency   */ {},
+	/* Spectrum  */ {},
+};
+static_assert(sizeof(pagesWidgets) / sizeof(pagesWidgets[0]) == static_cast<unsigned int>(Page::Count));
+
+/// Starts showing the widgets of current page (on cleared screen).
+void showPageWidgets()
+{
+	const auto& page = pagesWidgets[static_cast<unsigned int>(::page)];
+	widgetRenderer.show(page.widgets, page.count);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Setup
 
@@ -180,6 +604,9 @@ void setup()
 {
 	// Initialize the serial port
 	//Serial.begin(115200); // unavailable AUX 1 & 2 taking RX/TX... 
+#ifdef PROFILER_SERIAL
+	PROFILER_SERIAL.begin(115200); // for the profiler dumps, like `USBSerial`
+#endif
 
 	// Set pin modes
 	pinMode(THROTTLE_PIN,   INPUT);
@@ -209,54 +636,66 @@ void setup()
 	tft.initR(INITR_MINI160x80_PLUGIN);
 	tft.fillScreen(ST77XX_BLACK);
 	tft.setRotation(1);
-
-	// Initialize the EEPROM
-	EEPROM.begin(sizeof(Settings));
-	settings = reinterpret_cast<Settings*>(EEPROM.getDataPtr());
-	if (resetToDefaults || !settings->validate()) {
-		settings->resetToDefault();
-		settings->prepareForSave();
-		EEPROM.commit();
+	largeGlyphs.begin(FreeSans12pt7b, largeGlyphsCharacters, ST77XX_WHITE, ST77XX_BLACK);
+	largeGoodGlyphs.begin(FreeSans12pt7b, largeGlyphsCharacters, ST77XX_GREEN, ST77XX_BLACK);
+	largeFairGlyphs.begin(FreeSans12pt7b, largeGlyphsCharacters, ST77XX_YELLOW, ST77XX_BLACK);
+	largeBadGlyphs.begin(FreeSans12pt7b, largeGlyphsCharacters, ST77XX_RED, ST77XX_BLACK);
+	mediumGlyphs.begin(FreeSans9pt7b, "0123456789-", ST77XX_WHITE, ST77XX_BLACK);
+	mediumNamesGlyphs.begin(FreeSans9pt7b, mediumNamesCharacters, ST77XX_WHITE, ST77XX_BLACK);
+
+	// Load the settings (saved records over the defaults); first time take them from the EEPROM blob, if any
+	const bool loaded = settingsStore.begin("settings", Settings::storeVersion, &settings, sizeof(Settings),
+		settingsRecords, sizeof(settingsRecords) / sizeof(settingsRecords[0]));
+	if (!loaded && !resetToDefaults) {
+		EEPROM.begin(sizeof(Settings));
+		Settings* legacy = reinterpret_cast<Settings*>(EEPROM.getDataPtr());
+		if (legacy->validateLegacy()) {
+			memcpy(settings.calibration, legacy->calibration, sizeof(settings.calibration));
+			if (legacy->version >= 3) settings.linkProfile = legacy->linkProfile;
+		}
+		EEPROM.end();
+		settingsStore.saveAll();
+	}
+	if (resetToDefaults) {
+		settings.resetToDefault();
+		settingsStore.saveAll();
 		tft.fillScreen(ST77XX_BLUE);
 		delay(1000);
 	}
 
+	// Start pushing the frame buffer to the display
+	screen.begin(tft, tft_spi, TFT_SCLK, TFT_MOSI, TFT_CS, TFT_DC, 20'000'000);
+	showPageWidgets();
+
 	// Initialize the radio
 	radio.begin(&radio_spi, RF24_CE, RF24_CSN);
-	radio.setDataRate(RF24_250KBPS);
+	setRadioProfile(linkProfiles[selectedLinkProfile()]);
 	radio.setPALevel(RF24_PA_MAX);
-	radio.setAutoAck(false);
-	radio.setRetries(0, 0);
-	radio.setPayloadSize(staticPayloadSize);
-	radio.setCRCLength(RF24_CRC_8);
-	radio.openReadingPipe(1, transmitterInputAddress);
+	radio.setAutoAck(true);
+	radio.enableDynamicPayloads();
+	radio.enableAckPayload(); // receiver status comes back with the acknowledgements
 	radio.openWritingPipe(transmitterOutputAddress);
+#if !LINK_FHSS
+	radio.setChannel(LINK_CHANNEL);
+#endif
 	radio.stopListening();
+
+	// Start sampling the analog inputs in background
+	analogSampler.begin(analogInputs, sizeof(analogInputs) / sizeof(analogInputs[0]));
+
+	// Start the radio task on the other core than the UI (Arduino `loop()`)
+	compileSettings();
+	xTaskCreatePinnedToCore(radioTask, "radio", radioTaskStackSize, nullptr, 
+		radioTaskPriority, nullptr, radioTaskCore);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Loop
 
-uint16_t mapAnalogValue(uint16_t value, AnalogChannelCalibrationData& calibration)
-{
-	// The safety constrain is applied in the receiver side, keeping servos in range 700-2300 us.
-	if (calibration.rawMin == calibration.rawCenter) {
-		// Single linear curve based on min & max values
-		return map(value, calibration.rawMin, calibration.rawMax, calibration.usMin, calibration.usMax);
-	}
-	else /* rawMin != rawCenter */ {
-		// Two curves based on min & center and center & max values
-		if (value < calibration.rawCenter)
-			return map(value, calibration.rawMin, calibration.rawCenter, calibration.usMin, calibration.usCenter);
-		else
-			return map(value, calibration.rawCenter, calibration.rawMax, calibration.usCenter, calibration.usMax);
-	}
-}
-
 AnalogChannel trySelectChannel()
 {
 	for (int8_t i = 0; i < 5; i++) {
-		int delta = settings->calibration[i].rawCenter - rawAnalogValues[i];
+		int delta = settings.calibration[i].rawCenter - rawAnalogValues[i];
 		if (delta < 0) delta = -delta;
 		if (delta > 100) {
 			return static_cast<AnalogChannel>(i);
@@ -306,71 +745,162 @@ std::tuple<int16_t, int16_t> getOtherThanSelectedJoystickDeltas()
 	}
 }
 
-void loop()
+////////////////////////////////////////////////////////////////////////////////
+// Radio task
+
+/// Compiles changed calibration & mixer into the spare buffers & hands them
+/// over to the radio task. Done by the UI, as recompiling a table takes a while
+/// (~0.7 ms each), too long for the control frame; also the UI is the one
+/// changing the settings, so the radio task never sees them half-changed
+/// (like mix lines cleared by a preset, but not filled yet). Selected link
+/// profile & channel are handed over as atomic bytes, so the radio task
+/// never reads the settings.
+void compileSettings()
 {
-	unsigned long now = millis();
+	compiledCalibration.update([](CompiledCalibration& spare) {
+		return spare.update(settings.calibration) > 0;
+	});
+	compiledMixer.update([](CompiledMixer& spare) {
+		return spare.update(settings.mixer) > 0;
+	});
+	publishedLinkProfile.store(selectedLinkProfile());
+	publishedLinkChannel.store(selectedLinkChannel());
+}
 
-	// Read raw analog values
-	rawAnalogValues[0] = analogRead(THROTTLE_PIN);
-	rawAnalogValues[1] = analogRead(RUDDER_PIN);
-	rawAnalogValues[2] = analogRead(ELEVATOR_PIN);
-	rawAnalogValues[3] = analogRead(AILERON_PIN);
-	rawAnalogValues[4] = analogRead(CHANNEL_5_PIN);
-	rawAnalogValues[5] = 0;
-
-	// Map the values to microseconds
-	mappedValues[0] = mapAnalogValue(rawAnalogValues[0], settings->calibration[0]);
-	mappedValues[1] = mapAnalogValue(rawAnalogValues[1], settings->calibration[1]);
-	mappedValues[2] = mapAnalogValue(rawAnalogValues[2], settings->calibration[2]);
-	mappedValues[3] = mapAnalogValue(rawAnalogValues[3], settings->calibration[3]);
-	mappedValues[4] = mapAnalogValue(rawAnalogValues[4], settings->calibration[4]);
-	mappedValues[5] = mapAnalogValue(rawAnalogValues[5], settings->calibration[5]);
-	// TODO: clean it up somehow, feels very messy...
-	
-	// Send transmitter signal
-	txSignal.packetType = PacketType::Control;
-	txSignal.controlPacket.throttle = mappedValues[0];
-	txSignal.controlPacket.rudder   = mappedValues[1];
-	txSignal.controlPacket.elevator = mappedValues[2];
-	txSignal.controlPacket.aileron  = mappedValues[3];
-	txSignal.controlPacket.channel5 = mappedValues[4];
-	txSignal.controlPacket.aux1     = digitalRead(AUX_1_PIN);
-	txSignal.controlPacket.aux2     = digitalRead(AUX_2_PIN);
-	txSignal.controlPacket.aux3     = digitalRead(AUX_3_PIN);
-	const unsigned long timeSinceLastRxSignal = now - lastRxSignalTime;
-	if (timeSinceLastRxSignal > rxSignalFetchInterval) {
-		txSignal.controlPacket.request = TransmitterRequest::Status;
+/// Sweeps next channels with the receive power detector, in spare time of
+/// the control frame (up to 3/4 of the period, leaving the rest for jitter),
+/// but no longer than `maxScanTime`: the analog sampler runs on the same
+/// core below the radio task, and its DMA buffers hold only ~8 ms of
+/// conversions. Radio listens on each channel long enough for the detector
+/// (settling & 40 us of the signal), then goes back to transmitting; next
+/// frame sets its channel again.
+void scanSpectrum()
+{
+	constexpr uint32_t detectorTime = 130 + 40; // us, from entering RX mode
+	constexpr uint32_t maxScanTime = 2'000; // us, per frame
+	static uint32_t channelTime = 250; // us, whole single channel scan, as measured
+	const uint32_t budget = frameScheduler.interval() * 3 / 4;
+	const uint32_t start = micros();
+	while (frameScheduler.elapsed() + channelTime < budget && micros() - start + channelTime < maxScanTime) {
+		const uint32_t channelStart = micros();
+		radio.setChannel(spectrum.next);
+		radio.startListening();
+		delayMicroseconds(detectorTime);
+		const bool hit = radio.testRPD();
+		radio.stopListening();
+		spectrum.add(hit);
+		channelTime = micros() - channelStart;
 	}
-	else {
-		txSignal.controlPacket.request = TransmitterRequest::None;
+	radio.flush_rx(); // anything caught meanwhile
+#if !LINK_FHSS
+	radio.setChannel(fixedLinkChannel(transmitterLink.state.linkChannel));
+#endif
+	spectrumScanTime.add(micros() - start);
+	spectrumState.store({ spectrum, spectrumScanTime.average() });
+}
+
+/// Samples and maps the controls and sends control frame (receiving status
+/// in the ACK payloads), at rate driven by the frame scheduler. 
+/// Independent from the UI drawing.
+void radioTask(void*)
+{
+	RadioState state {};
+	auto& link = transmitterLink;
+	link.state.linkProfile = publishedLinkProfile.load(); // as set up
+	frameScheduler.setRate(linkProfiles[link.state.linkProfile].frameRate);
+	frameScheduler.begin();
+	while (true) {
+		frameScheduler.waitForFrame();
+
+		// Resets requested by the UI, done here as this task writes the values
+		profiler.resetIfRequested();
+		if (latencyResetRequested.exchange(false)) {
+			latencyMeter.reset();
+		}
+		if (spectrumResetRequested.exchange(false)) {
+			spectrum.reset();
+			spectrumScanTime.reset();
+		}
+
+		ProfileLap lap;
+		const uint32_t stamp = micros(); // of sampling the controls, for the latency mode
+
+		// Take latest raw analog values (already oversampled & filtered)
+		const auto analog = analogSampler.load();
+		memcpy(state.rawAnalogValues, analog.values, 5 * sizeof(uint16_t));
+		state.rawAnalogValues[5] = 0;
+		state.txBatteryRaw = analog.values[transmitterBatteryInputIndex];
+		lap.end(ProfileStage::Sample);
+
+		// Map the values to microseconds, using lookup tables compiled from the calibration,
+		// then mix them into the channels (spare ones carry the switches, as 2-position channels)
+		auto& frame = link.state.controlFrame;
+		frame.setAux(0, digitalRead(AUX_1_PIN));
+		frame.setAux(1, digitalRead(AUX_2_PIN));
+		frame.setAux(2, digitalRead(AUX_3_PIN));
+		compiledCalibration.take().map(state.rawAnalogValues, state.mappedValues);
+		compiledMixer.take().mix(state.mappedValues, frame.switches, frame.channels);
+		lap.end(ProfileStage::Map);
+
+		// Send transmitter signal
+		link.pack(publishedLinkProfile.load(), publishedLinkChannel.load(), latencyMode.load(), stamp);
+		lap.end(ProfileStage::Pack);
+		link.write();
+		lap.end(ProfileStage::Write);
+		link.receive();
+		lap.end(ProfileStage::Status);
+
+		if (link.endFrame()) {
+			setRadioProfile(linkProfiles[link.state.linkProfile]);
+			frameScheduler.setRate(linkProfiles[link.state.linkProfile].frameRate);
+		}
+
+		state.link = link.state;
+		radioState.store(state);
+		lap.end(ProfileStage::Publish);
+
+		if (spectrumScan.load()) {
+			scanSpectrum();
+		}
+
+		frameScheduler.endFrame();
 	}
-	radio.write(&txSignal, sizeof(txSignal));
-	lastTxSignalTime = now;
+}
 
-	if (txSignal.controlPacket.request != TransmitterRequest::None) {
-		radio.startListening();
-		unsigned long listenStartTime = millis();
-		do {
-			now = millis();
-			if (radio.available()) {
-				radio.read(&rxSignal, sizeof(rxSignal));
-				lastRxSignalTime = now;
-				lastRxSignalLastLatency = now - listenStartTime;
-				break;
-			}
+////////////////////////////////////////////////////////////////////////////////
+// Loop (UI)
+
+void loop()
+{
+	unsigned long now = millis();
+
+	// Take the latest state from the radio task
+	{
+		const RadioState state = radioState.load();
+		memcpy(rawAnalogValues, state.rawAnalogValues, sizeof(rawAnalogValues));
+		memcpy(mappedValues, state.mappedValues, sizeof(mappedValues));
+		txBatteryRaw = state.txBatteryRaw;
+		controlFrame = state.link.controlFrame;
+		rxSignal = state.link.rxSignal;
+		lastRxSignalTime = state.link.lastRxSignalTime;
+		sentCount = state.link.sentCount;
+		ackedCount = state.link.ackedCount;
+		linkProfile = state.link.linkProfile;
+		if (linkChannel != state.link.linkChannel) {
+			linkChannel = state.link.linkChannel;
+			linkHops = makeHopSequence(LINK_BIND_SEED, linkChannel);
 		}
-		while (now - listenStartTime < rxSignalListenDuration);
-		radio.stopListening();
+		memcpy(linkProfileStats, state.link.linkProfileStats, sizeof(linkProfileStats));
 	}
+	timeSinceLastRxSignal = now - lastRxSignalTime;
 
-	// Buzzer testing, since it sounds weird...
-	digitalWrite(BUZZER_PIN, analogRead(THROTTLE_PIN) > 1600 ? HIGH : LOW);
+	// Hand over changes of the settings made by previous loop
+	compileSettings();
 
-	// Transmitter battery uses 15V to 3.235V divider (12kOhm & 3.3kOhm),
-	// ESP32S3 has 12-bit ADC.
-	constexpr float txBatteryFactor = 3.235 / 4095.0 * (12000.0 + 3300.0) / 3300.0;
-	uint16_t txBatteryRaw = analogRead(TRANSMITTER_BATTERY_PIN);
+	// Buzzer testing, since it sounds weird...
+	digitalWrite(BUZZER_PIN, rawAnalogValues[0] > 1600 ? HIGH : LOW);
 
+	ProfileLap lap;
 	bool wasLongPress = false;
 	if (f1ButtonPressed) {
 		if (digitalRead(F1_PIN) == LOW) /* still pressed */ {
@@ -382,15 +912,16 @@ void loop()
 			}
 			else /* short press finished */ {
 				switch (page) {
-					case Page::Calibrate: {
-						if (settings->prepareForSave())
-							EEPROM.commit();
+					case Page::Calibrate:
+					case Page::Mixer: {
+						settingsStore.save();
 					}
 					default:
 						break;
 				}
 				goNextPage();
-				tft.fillScreen(ST77XX_BLACK);
+				screen.fillScreen(ST77XX_BLACK);
+				showPageWidgets();
 				switch (page) {
 					case Page::Calibrate: {
 						selectedChannel = AnalogChannel::Throttle;
@@ -402,6 +933,15 @@ void loop()
 						selectedChannel = AnalogChannel::Throttle;
 						break;
 					}
+					case Page::Mixer: {
+						selectedChannel = AnalogChannel::Throttle;
+						parameterSelected = 0; // preset
+						break;
+					}
+					case Page::Spectrum: {
+						spectrumDrawn = false;
+						break;
+					}
 					default: 
 						break;
 				}
@@ -412,144 +952,31 @@ void loop()
 	else {
 		f1ButtonPressed = digitalRead(F1_PIN) == LOW ? now : 0;
 	}
-
-	// TODO: prevent blinking of the screen when drawing stuff; this is useless...?
-	// static unsigned long lastDraw = 0;
-	// if (now - lastDraw < 20)
-	// 	return;
-	// lastDraw = now;
+	lap.end(ProfileStage::Input);
+	spectrumScan.store(page == Page::Spectrum);
 
 	// Default for the pages
-	tft.setTextColor(ST77XX_WHITE);
-	tft.setFont(); // to default
-	tft.setCursor(0, 0);
+	const unsigned long renderStartTime = micros();
+	const Page renderedPage = page;
+	screen.setTextColor(ST77XX_WHITE);
+	screen.setFont(); // to default
+	screen.setCursor(0, 0);
 
 	switch (page) {
-		case Page::Info: {
-			tft.setFont(&FreeSans9pt7b);
-			tft.setCursor(0, 20);
-			tft.printf("Nadajnik:");
-			tft.setCursor(0, 40);
-			tft.printf("Odbiornik:");
-			tft.setCursor(0, 60);
-			tft.printf("Sygnal:");
-
-			tft.fillRect(96, 0, 160 - 96 - 1, 60 + 1, ST77XX_BLACK);
-			tft.setFont(&FreeSans12pt7b);
-			tft.setCursor(96, 20);
-			tft.printf("%.2fV", txBatteryFactor * txBatteryRaw); // TODO: show only 1 digit after dot, if >10V
-			tft.setCursor(96, 40);
-			tft.printf("%.2fV", rxSignal.statusPacket.battery);
-			tft.setCursor(96, 60);
-			if (timeSinceLastRxSignal < rxSignalLostDuration) /* good */ {
-				long lateStatusPenalty = 33 * max<long>(0, static_cast<long>(timeSinceLastRxSignal) - rxSignalFetchInterval)
-					/ (rxSignalLostDuration - rxSignalFetchInterval);
-				uint8_t finalRating = rxSignal.statusPacket.signalRating + 33 - constrain(lateStatusPenalty, 0, 33);
-				tft.setTextColor(ST77XX_GREEN);
-				tft.printf("%hhu", finalRating);
-			}
-			else /* signal lost, bad */ {
-				tft.setTextColor(ST77XX_RED);
-				tft.printf("brak!");
-			}
-			break;
-		}
-		case Page::Raw: {
-			tft.fillScreen(ST77XX_BLACK);
-			tft.printf(
-				"Surowe wartosci:\n"
-				" throttle=%hu\n"
-				" rudder=%hu\n"
-				" elevator=%hu\n"
-				" aileron=%hu\n"
-				" channel5=%hu\n"
-				" aux1=%u\n"
-				" aux2=%u\n"
-				" aux3=%u\n",
-				rawAnalogValues[0],
-				rawAnalogValues[1],
-				rawAnalogValues[2],
-				rawAnalogValues[3],
-				rawAnalogValues[4],
-				txSignal.controlPacket.aux1,
-				txSignal.controlPacket.aux2,
-				txSignal.controlPacket.aux3
-			);
-			break;
-		}
 		case Page::Centered: {
-			tft.print("Wartosci od srodka:");
-
-			tft.setFont(&FreeSans9pt7b);
-			constexpr int div = 6; // losing some accuracy for easier displaying & reading
-
-			tft.setCursor(0, 12 + 1 * 16);
-			tft.print("THR:");
-			tft.setCursor(0, 12 + 2 * 16);
-			tft.print("RUD:");
-			tft.setCursor(80, 12 + 1 * 16);
-			tft.print("ELV:");
-			tft.setCursor(80, 12 + 2 * 16);
-			tft.print("AIL:");
-			tft.setCursor(0, 12 + 3 * 16);
-			tft.print("CH5:");
-
-			constexpr int labelsWidth = 42;
-			tft.fillRect(0 + labelsWidth, 14, 80 - labelsWidth, 3 * 16, ST77XX_BLACK);
-			tft.fillRect(80 + labelsWidth, 14, 80 - labelsWidth, 3 * 16, ST77XX_BLACK);
-			tft.setCursor(0 + labelsWidth, 12 + 1 * 16);
-			tft.printf("%hd", (txSignal.controlPacket.throttle - settings->calibration[0].usCenter) / div);
-			tft.setCursor(0 + labelsWidth, 12 + 2 * 16);
-			tft.printf("%hd", (txSignal.controlPacket.rudder   - settings->calibration[1].usCenter) / div);
-			tft.setCursor(80 + labelsWidth, 12 + 1 * 16);
-			tft.printf("%hd", (txSignal.controlPacket.elevator - settings->calibration[2].usCenter) / div);
-			tft.setCursor(80 + labelsWidth, 12 + 2 * 16);
-			tft.printf("%hd", (txSignal.controlPacket.aileron  - settings->calibration[3].usCenter) / div);
-			tft.setCursor(0 + labelsWidth, 12 + 3 * 16);
-			tft.printf("%hd", (txSignal.controlPacket.channel5 - settings->calibration[4].usCenter) / div);
-
-			tft.setFont(); // to default
-			tft.setCursor(6, 80 - 12);
-			tft.fillRect(40, 80 - 12, 8, 8, ST77XX_BLACK);
-			tft.fillRect(94, 80 - 12, 8, 8, ST77XX_BLACK);
-			tft.fillRect(148, 80 - 12, 8, 8, ST77XX_BLACK);
-			tft.printf(
-				"AUX1: %u  AUX2: %u  AUX3: %u", 
-				txSignal.controlPacket.aux1,
-				txSignal.controlPacket.aux2,
-				txSignal.controlPacket.aux3
-			);
-
 			if (wasLongPress) {
-				settings->calibration[0].rawCenter = rawAnalogValues[0];
-				settings->calibration[1].rawCenter = rawAnalogValues[1];
-				settings->calibration[2].rawCenter = rawAnalogValues[2];
-				settings->calibration[3].rawCenter = rawAnalogValues[3];
-				settings->calibration[4].rawCenter = rawAnalogValues[4];
-				if (settings->prepareForSave())
-					EEPROM.commit();
+				settings.calibration[0].rawCenter = rawAnalogValues[0];
+				settings.calibration[1].rawCenter = rawAnalogValues[1];
+				settings.calibration[2].rawCenter = rawAnalogValues[2];
+				settings.calibration[3].rawCenter = rawAnalogValues[3];
+				settings.calibration[4].rawCenter = rawAnalogValues[4];
+				settingsStore.save();
 			}
 			break;
 		}
 		case Page::Calibrate: {
-			tft.setCursor(0, 0);
-			tft.printf("Kalibracja");
-
-			constexpr auto channelX = 12;
-			constexpr auto channelY = 12;
-			constexpr auto currentsY = 24;
-			constexpr auto valuesY = 40;
-
-			// Print current value (raw & mapped)
-			tft.fillRect(2 + 24, currentsY - 2, 32, 12, ST77XX_BLACK);
-			tft.setCursor(2, currentsY);
-			tft.printf("raw=%u\n", rawAnalogValues[static_cast<int8_t>(selectedChannel)]);
-			tft.fillRect(82 + 18, currentsY - 2, 32, 12, ST77XX_BLACK);
-			tft.setCursor(82, currentsY);
-			tft.printf("us=%u\n", mappedValues[static_cast<int8_t>(selectedChannel)]);
-
 			// Handle joystick input
-			auto& c = settings->calibration[static_cast<int8_t>(selectedChannel)];
+			auto& c = settings.calibration[static_cast<int8_t>(selectedChannel)];
 			const auto [x, y] = getOtherThanSelectedJoystickDeltas();
 			if (now - cooldownTime > 512) {
 				if (y < -100) {
@@ -570,15 +997,8 @@ void loop()
 			}
 			// TODO: avoid using throttle joystick?
 
-			// Clear dynamic fields
-			tft.fillRect(channelX + 40, channelY - 2, 76, 12, ST77XX_BLACK);
-			tft.fillRect(2 + 40, valuesY - 2, 32, 3 * 12, ST77XX_BLACK);
-			tft.fillRect(82 + 34, valuesY - 2, 32, 3 * 12, ST77XX_BLACK);
-
-			// Mark the channel or selected parameter, and update the values by the way
-			constexpr uint16_t markColor = 0x7BEF; // gray
+			// Update the channel or selected parameter (widgets mark it)
 			if (parameterSelected == 6) {
-				tft.drawRect(channelX + 40, channelY - 2, 76, 12, markColor);
 				if (delta != 0) {
 					if (delta < 0)
 						selectedChannel = static_cast<AnalogChannel>((static_cast<int8_t>(selectedChannel) + 4) % 5);
@@ -587,10 +1007,6 @@ void loop()
 				}
 			}
 			else {
-				if (parameterSelected < 3)
-					tft.drawRect(0, valuesY - 2 + parameterSelected * 12, 76, 12, markColor);
-				else
-					tft.drawRect(80, valuesY - 2 + (parameterSelected - 3) * 12, 76, 12, markColor);
 				switch (parameterSelected) {
 					case 0: c.rawMin    += delta; break;
 					case 1: c.rawCenter += delta; break;
@@ -601,24 +1017,6 @@ void loop()
 				}
 			}
 
-			// Print channel
-			tft.setCursor(channelX, channelY);
-			tft.printf("Kanal: %s", channelNames[static_cast<int8_t>(selectedChannel)]);
-
-			// Print the calibration values
-			tft.setCursor(2, valuesY + 0 * 12);
-			tft.printf("rawMin=%u", c.rawMin);
-			tft.setCursor(2, valuesY + 1 * 12);
-			tft.printf("rawCtr=%u", c.rawCenter);
-			tft.setCursor(2, valuesY + 2 * 12);
-			tft.printf("rawMax=%u", c.rawMax);
-			tft.setCursor(82, valuesY + 0 * 12);
-			tft.printf("usMin=%u", c.usMin);
-			tft.setCursor(82, valuesY + 1 * 12);
-			tft.printf("usCtr=%u", c.usCenter);
-			tft.setCursor(82, valuesY + 2 * 12);
-			tft.printf("usMax=%u", c.usMax);
-
 			// On long press select current value (most useful on raw analog values)
 			if (wasLongPress) {
 				switch (parameterSelected) {
@@ -634,23 +1032,9 @@ void loop()
 			break;
 		}
 		case Page::Reverse: {
-			tft.setCursor(0, 0);
-			tft.printf("Odwracanie");
-
-			// Print current channel
-			tft.fillRect(8 + 52, 11, 120, 17, ST77XX_BLACK);
-			tft.setFont(&FreeSans9pt7b);
-			tft.setCursor(8, 24);
-			tft.printf("Kanal: %s", channelNames[static_cast<int8_t>(selectedChannel)]);
-
-			auto& c = settings->calibration[static_cast<int8_t>(selectedChannel)];
-			const bool reversed = c.usMin > c.usMax;
-
-			// Print current reverse state
-			tft.fillRect(8 + 42, 28, 120, 17, ST77XX_BLACK);
-			tft.setCursor(8, 40);
-			tft.printf("Stan: %s", reversed ? "rewers >" : "< normalny");
-
+			// Handle joystick input: channel selection (up/down), reverse state (left/right; widgets show both)
+			auto& c = selectedCalibration();
+			const bool reversed = isSelectedChannelReversed();
 			if (now - cooldownTime > 512) {
 				const auto [x, y] = getJoystickDeltas(true);
 				if (y < -100) {
@@ -665,22 +1049,339 @@ void loop()
 					auto tmp = c.usMin;
 					c.usMin = c.usMax;
 					c.usMax = tmp;
-					if (settings->prepareForSave())
-						EEPROM.commit();
+					settingsStore.save();
 					cooldownTime = now;
 				}
 				else if (100 < x && !reversed) {
 					auto tmp = c.usMin;
 					c.usMin = c.usMax;
 					c.usMax = tmp;
-					if (settings->prepareForSave())
-						EEPROM.commit();
+					settingsStore.save();
 					cooldownTime = now;
 				}
 			}
 			break;
 		}
+		case Page::Mixer: {
+			screen.fillScreen(ST77XX_BLACK);
+			screen.printf("Mikser\n");
+
+			// Parameters: preset, channel, rates switch, expo & rate for switch off/on, trim
+			constexpr int8_t parametersCount = 8;
+			auto& mixer = settings.mixer;
+			auto& input = mixer.inputs[static_cast<int8_t>(selectedChannel)];
+			const auto [x, y] = getJoystickDeltas(true);
+			if (now - cooldownTime > 512) {
+				if (y < -100) {
+					parameterSelected = (parameterSelected + parametersCount - 1) % parametersCount;
+					cooldownTime = now;
+				}
+				else if (100 < y) {
+					parameterSelected = (parameterSelected + 1) % parametersCount;
+					cooldownTime = now;
+				}
+			}
+			int delta = 0;
+			if (now - cooldownTime > (parameterSelected < 3 ? 512 : 64)) {
+				if (x < -100 || 100 < x) {
+					delta = x / 128;
+					cooldownTime = now;
+				}
+			}
+			if (delta != 0) {
+				const int8_t step = delta < 0 ? -1 : 1;
+				switch (parameterSelected) {
+					case 0: {
+						constexpr uint8_t presetsCount = static_cast<uint8_t>(MixPreset::Custom);
+						const uint8_t current = static_cast<uint8_t>(mixer.preset()) % presetsCount;
+						mixer.applyPreset(static_cast<MixPreset>((current + presetsCount + step) % presetsCount));
+						break;
+					}
+					case 1:
+						selectedChannel = static_cast<AnalogChannel>((static_cast<int8_t>(selectedChannel) + 5 + step) % 5);
+						break;
+					case 2:
+						input.rateSwitch = (input.rateSwitch + 1 + 4 + step) % 4 - 1; // none, AUX 1-3
+						break;
+					case 3: input.expo[0] = constrain(input.expo[0] + delta, 0, 100); break;
+					case 4: input.rate[0] = constrain(input.rate[0] + delta, 0, 150); break;
+					case 5: input.expo[1] = constrain(input.expo[1] + delta, 0, 100); break;
+					case 6: input.rate[1] = constrain(input.rate[1] + delta, 0, 150); break;
+					case 7: input.trim    = constrain(input.trim    + delta, -200, 200); break;
+				}
+			}
+
+			// Print the parameters, marking selected one
+			const auto mark = [](int8_t parameter) { return parameterSelected == parameter ? '>' : ' '; };
+			screen.printf("%cMiks: %s\n", mark(0), mixPresetNames[static_cast<uint8_t>(mixer.preset())]);
+			screen.printf("%cKanal: %s\n", mark(1), channelNames[static_cast<int8_t>(selectedChannel)]);
+			if (input.rateSwitch < 0)
+				screen.printf("%cPrzelacznik: brak\n", mark(2));
+			else
+				screen.printf("%cPrzelacznik: AUX %hhd\n", mark(2), input.rateSwitch + 1);
+			screen.printf(" Wyl%cexpo%4hhu%%%crate%4hhu%%\n", mark(3), input.expo[0], mark(4), input.rate[0]);
+			screen.printf(" Wl %cexpo%4hhu%%%crate%4hhu%%\n", mark(5), input.expo[1], mark(6), input.rate[1]);
+			screen.printf("%cTrym: %hd us\n", mark(7), input.trim);
+			screen.printf(" Wyjscie: %hu us\n", controlFrame.channels[static_cast<int8_t>(selectedChannel)]);
+			break;
+		}
+		case Page::Timing: {
+			screen.setCursor(0, 0);
+			screen.printf("Czasy ramek");
+
+			// Link profile selection (sets the rate, once the radio task switches to it)
+			if (now - cooldownTime > 512) {
+				const auto [x, y] = getJoystickDeltas(true);
+				if (x < -100 || 100 < x) {
+					const uint8_t step = x < 0 ? linkProfilesCount - 1 : 1;
+					settings.linkProfile = (selectedLinkProfile() + step) % linkProfilesCount;
+					settingsStore.save();
+					cooldownTime = now;
+				}
+			}
+			if (wasLongPress) {
+				frameScheduler.requestResetStats();
+			}
+
+			// Print the statistics
+			const auto& jitter = frameScheduler.jitter;
+			const auto& loopTime = frameScheduler.loopTime;
+			screen.fillRect(0, 10, 160, 50, ST77XX_BLACK);
+			screen.setCursor(0, 12);
+			screen.printf("< %s %u Hz >\n", linkProfileNames[selectedLinkProfile()], frameScheduler.rate());
+			screen.printf("ramki=%lu spoznione=%lu\n", frameScheduler.framesCount, frameScheduler.missedCount);
+			screen.printf("jitter avg/p99/max [us]:\n %lu/%lu/%lu\n", 
+				jitter.average(), jitter.percentile(99), jitter.max);
+			screen.printf("petla %lu/%lu/%lu", 
+				loopTime.average(), loopTime.percentile(99), loopTime.max);
+
+			// Jitter histogram (logarithmic buckets, up to ~4 ms)
+			constexpr uint8_t bucketsShown = 13;
+			constexpr int16_t barWidth = 160 / bucketsShown;
+			constexpr int16_t barsTop = 62;
+			constexpr int16_t barsHeight = 80 - barsTop;
+			const uint32_t count = max<uint32_t>(jitter.count, 1);
+			for (uint8_t i = 0; i < bucketsShown; i++) {
+				const int16_t h = min<uint32_t>(barsHeight, 
+					(jitter.buckets[i] * barsHeight + count - 1) / count);
+				const int16_t x = i * barWidth;
+				screen.fillRect(x, barsTop, barWidth - 1, barsHeight - h, ST77XX_BLACK);
+				screen.fillRect(x, 80 - h, barWidth - 1, h, ST77XX_GREEN);
+			}
+			break;
+		}
+		case Page::Render: {
+			screen.fillScreen(ST77XX_BLACK);
+			screen.printf("Rysowanie [us] avg/max\n");
+			for (unsigned int i = 0; i < static_cast<unsigned int>(Page::Count); i++) {
+				// Two columns, to fit all the pages
+				screen.setCursor((i % 2) * 80, 8 + (i / 2) * 8);
+				screen.printf("%-4.4s%4lu/%lu", pageNames[i], 
+					pageRenderTimes[i].average(), pageRenderTimes[i].max);
+			}
+			screen.setCursor(0, 8 + (static_cast<unsigned int>(Page::Count) + 1) / 2 * 8);
+			screen.printf(" Wysyl %lu/%lu czek %lu\n", screen.flushTime.average(), screen.flushTime.max,
+				screen.waitTime.average());
+			screen.printf(" Zapis %lu/%lu n=%lu/%lu/%hhu\n", settingsStore.writeTime.average(), settingsStore.writeTime.max,
+				settingsStore.writesCount, settingsStore.failedCount, settingsStore.pendingCount());
+			const float mhz = getCpuFrequencyMhz();
+			const auto& textTime = GlyphCache::drawTime;
+			screen.printf(" Tekst %.1f/%.1f px=%lu", textTime.average() / mhz, textTime.max / mhz, screen.lastFlushPixelsCount);
+			if (wasLongPress) {
+				for (auto& stats : pageRenderTimes) stats.reset();
+				screen.requestResetStats();
+				settingsStore.requestResetStats();
+				GlyphCache::drawTime.reset();
+			}
+			break;
+		}
+		case Page::Link: {
+			screen.fillScreen(ST77XX_BLACK);
+			screen.printf("Lacze: %s\n", linkProfileNames[linkProfile]);
+			if (timeSinceLastRxSignal < rxSignalLostDuration) {
+				const auto& status = rxSignal.statusPacket;
+				screen.printf(" utracone %hhu%%  luka %hhu\n", status.lossPercent, status.longestGap);
+				screen.printf(" jitter %hu us silny %s\n", status.jitter, status.goodSignal ? "tak" : "nie");
+				screen.printf(" ocena %hhu%% status %lu ms\n", status.signalRating, timeSinceLastRxSignal);
+			}
+			else {
+				screen.setTextColor(ST77XX_RED);
+				screen.printf(" brak statusu! (%lu ms)\n\n\n", timeSinceLastRxSignal);
+				screen.setTextColor(ST77XX_WHITE);
+			}
+			screen.printf(" ACK: %lu/%lu (%lu%%)\n", ackedCount, sentCount, 
+				static_cast<unsigned long>(sentCount ? 100 * static_cast<uint64_t>(ackedCount) / sentCount : 0));
+
+			// Per profile: effective rate (acknowledged frames) & loss reported by the receiver
+			screen.printf(" profil      Hz ACK%% utr%%\n");
+			for (uint8_t i = 0; i < linkProfilesCount; i++) {
+				const auto& stats = linkProfileStats[i];
+				const char mark = i == linkProfile ? '>' : ' ';
+				if (!stats.sentCount) {
+					screen.printf("%c%-8.8s     -\n", mark, linkProfileNames[i]);
+					continue;
+				}
+				const float acked = static_cast<float>(stats.ackedCount) / stats.sentCount;
+				screen.printf("%c%-8.8s%6.1f%5.0f%5hhu\n", mark, linkProfileNames[i],
+					acked * linkProfiles[i].frameRate, 100 * acked, stats.lossPercent);
+			}
+			break;
+		}
+		case Page::Profile: {
+			screen.fillScreen(ST77XX_BLACK);
+			screen.printf("Etapy [us] avg/p99/max\n");
+			const float mhz = getCpuFrequencyMhz();
+			for (uint8_t i = 0; i < static_cast<uint8_t>(ProfileStage::Count); i++) {
+				const auto& stats = profiler.stages[i];
+				screen.printf("%-7.7s%6.1f%6.1f%7.1f\n", Profiler::stageNames[i],
+					stats.average() / mhz, stats.percentile(99) / mhz, stats.max / mhz);
+			}
+			if (wasLongPress) {
+#ifdef PROFILER_SERIAL
+				profiler.dump(PROFILER_SERIAL);
+#endif
+				profiler.requestReset();
+			}
+			break;
+		}
+		case Page::Latency: {
+			screen.fillScreen(ST77XX_BLACK);
+			screen.printf("Opoznienie < %s >\n", latencyMode.load() ? "wlaczone" : "wylaczone");
+
+			// Mode switch (receiver echoes the stamps as long as they come)
+			if (now - cooldownTime > 512) {
+				const auto [x, y] = getJoystickDeltas(true);
+				if (x < -100 || 100 < x) {
+					latencyMode.store(!latencyMode.load());
+					cooldownTime = now;
+				}
+			}
+			if (wasLongPress) {
+#ifdef PROFILER_SERIAL
+				latencyMeter.dump(PROFILER_SERIAL);
+#endif
+				latencyResetRequested = true;
+			}
+
+			// Percentiles, in milliseconds
+			const auto& oneWay = latencyMeter.oneWay;
+			const auto& roundTrip = latencyMeter.roundTrip;
+			screen.printf(" echo n=%lu stare=%lu\n", oneWay.count, latencyMeter.unmatchedCount);
+			screen.printf("[ms]   p50  p95  p99  max\n");
+			screen.printf("1-str%5.1f%5.1f%5.1f%5.1f\n", oneWay.percentile(50) / 1000.f,
+				oneWay.percentile(95) / 1000.f, oneWay.percentile(99) / 1000.f, oneWay.max / 1000.f);
+			screen.printf("obieg%5.1f%5.1f%5.1f%5.1f\n", roundTrip.percentile(50) / 1000.f,
+				roundTrip.percentile(95) / 1000.f, roundTrip.percentile(99) / 1000.f, roundTrip.max / 1000.f);
+
+			// One way histogram, 1 ms per bar, up to 40 ms
+			constexpr uint8_t bucketsPerBar = 1000 / LatencyHistogram::bucketWidth;
+			constexpr uint8_t barsCount = 40;
+			constexpr int16_t barWidth = 160 / barsCount;
+			constexpr int16_t barsTop = 42;
+			constexpr int16_t barsHeight = 80 - barsTop;
+			uint32_t bars[barsCount] = {};
+			uint32_t highest = 1;
+			for (uint8_t i = 0; i < barsCount; i++) {
+				for (uint8_t j = 0; j < bucketsPerBar; j++) bars[i] += oneWay.buckets[i * bucketsPerBar + j];
+				highest = max(highest, bars[i]);
+			}
+			for (uint8_t i = 0; i < barsCount; i++) {
+				const int16_t h = (bars[i] * barsHeight + highest - 1) / highest;
+				screen.fillRect(i * barWidth, 80 - h, barWidth - 1, h, ST77XX_GREEN);
+			}
+			break;
+		}
+		case Page::Spectrum: {
+			// Channel per column (2400-2525 MHz): level (hit rate) as the bar, peak as the dot
+			constexpr int16_t graphLeft = (160 - Spectrum::channelsCount) / 2;
+			constexpr int16_t graphTop = 9;
+			constexpr int16_t graphHeight = 47;
+			constexpr int16_t graphBottom = graphTop + graphHeight;
+			if (wasLongPress) {
+				spectrumResetRequested = true;
+			}
+
+			// Copy published by the radio task, as it keeps scanning meanwhile
+			const SpectrumState shown = spectrumState.load();
+			screen.fillRect(0, 0, 160, 8, ST77XX_BLACK);
+			screen.printf("Widmo n=%hu skan %lu us", shown.spectrum.sweepsCount, shown.scanTimeAverage);
+
+			// Only the changed columns are redrawn
+			for (uint8_t channel = 0; channel < Spectrum::channelsCount; channel++) {
+				const uint8_t level = shown.spectrum.levels[channel] * graphHeight / (Spectrum::levelMax + 1);
+				const uint8_t peak = shown.spectrum.peaks[channel] * graphHeight / (Spectrum::levelMax + 1);
+				if (spectrumDrawn && level == spectrumDrawnLevels[channel] && peak == spectrumDrawnPeaks[channel])
+					continue;
+				spectrumDrawnLevels[channel] = level;
+				spectrumDrawnPeaks[channel] = peak;
+				const int16_t x = graphLeft + channel;
+				screen.drawFastVLine(x, graphTop, graphHeight - level, ST77XX_BLACK);
+				screen.drawFastVLine(x, graphBottom - level, level, ST77XX_GREEN);
+				if (peak > level) {
+					screen.drawPixel(x, graphBottom - peak, ST77XX_YELLOW);
+				}
+			}
+			spectrumDrawn = true;
+
+			// Channels used by the link marked below, with ticks every 10 MHz
+			uint8_t busyLinkChannels = 0;
+			uint8_t linkChannelsCount = 0;
+			for (uint8_t channel = 0; channel < Spectrum::channelsCount; channel++) {
+				const bool link = isLinkChannel(channel);
+				screen.drawPixel(graphLeft + channel, graphBottom + 1, link ? ST77XX_BLUE 
+					: channel % 10 == 0 ? ST77XX_WHITE : ST77XX_BLACK);
+				if (link) {
+					linkChannelsCount += 1;
+					if (shown.spectrum.peaks[channel] > Spectrum::levelMax / 8) busyLinkChannels += 1;
+				}
+			}
+
+			// Choices for the link channel (first is the default): the quietest channels within
+			// the band used by the link, or with the hopping, the busiest bands to be avoided by it
+			uint8_t choices[4] = {};
+#if LINK_FHSS
+			const uint8_t choicesCount = 1 + shown.spectrum.busiestBands(choices + 1, 3, hopChannelMin, hopChannelMax, hopAvoidedHalfWidth);
+#else
+			const uint8_t choicesCount = 1 + shown.spectrum.quietest(choices + 1, 3, hopChannelMin, hopChannelMax, 4);
+#endif
+			if (now - cooldownTime > 512) {
+				const auto [x, y] = getJoystickDeltas(true);
+				if (x < -100 || 100 < x) {
+					uint8_t i = 0;
+					while (i < choicesCount && choices[i] != selectedLinkChannel()) i++;
+					if (i == choicesCount) i = 0; // not among the current ones, so start over
+					else i = (i + (x < 0 ? choicesCount - 1 : 1)) % choicesCount;
+					settings.linkChannel = choices[i];
+					settingsStore.save();
+					cooldownTime = now;
+				}
+			}
+
+			screen.fillRect(0, 60, 160, 20, ST77XX_BLACK);
+			screen.setCursor(0, 62);
+			screen.printf("Lacze: zajete %hhu/%hhu kan.\n", busyLinkChannels, linkChannelsCount);
+			const uint8_t selected = selectedLinkChannel();
+			const char pending = selected != linkChannel ? '*' : ' '; // until the receiver switches too
+#if LINK_FHSS
+			if (selected) {
+				screen.printf("< omin %u-%u MHz >%c", 2400 + selected - hopAvoidedHalfWidth,
+					2400 + selected + hopAvoidedHalfWidth, pending);
+			}
+			else {
+				screen.printf("< omin: nic >%c", pending);
+			}
+#else
+			screen.printf("< kanal %u MHz%s >%c", 2400 + fixedLinkChannel(selected), selected ? "" : " dom.", pending);
+#endif
+			break;
+		}
 		default:
 			break;
 	}
+	widgetRenderer.render(screen, now);
+	pageRenderTimes[static_cast<unsigned int>(renderedPage)].add(micros() - renderStartTime);
+	lap.end(ProfileStage::Render);
+
+	screen.flush();
+	lap.end(ProfileStage::Flush);
 }
@@ -0,0 +1,228 @@
+#pragma once
+#include <stdint.h>
+#include "common/packets.hpp"
+
+/// Mixer, between the calibrated inputs (us) and the control channels. Each
+/// input (sticks & the knob, as `AnalogChannel`) goes through its curve: expo
+/// & rate, from one of two sets selected by chosen AUX switch (dual rates),
+/// and trim. Then outputs are made as weighted sums of the inputs (switches
+/// included), by the mix lines; outputs without any line pass their own input.
+/// Defined as data (in the settings), compiled into lookup tables & fixed-point
+/// weights matrix, so mixing takes the same work whatever the setup.
+
+constexpr uint8_t mixerCurvedInputsCount = 5; // as `AnalogChannel`
+constexpr uint8_t mixerInputsCount = mixerCurvedInputsCount + 3; // followed by AUX switches
+constexpr uint16_t mixerNeutral = 1500; // us
+constexpr uint16_t mixerFullScale = 500; // us, deflection from neutral taken as 100%
+constexpr uint16_t mixerMaxDeflection = 800; // us, inputs are limited to 700-2300 us (as the receiver does)
+static_assert(mixerInputsCount == controlChannelsCount);
+
+struct MixerInputSettings
+{
+	uint8_t expo[2] = { 0, 0 }; // percent (0-100), for the switch off & on
+	uint8_t rate[2] = { 100, 100 }; // percent, for the switch off & on
+	int8_t rateSwitch = -1; // AUX index (0-2) selecting the set, -1 for none (first set only)
+	uint8_t _pad = 0;
+	int16_t trim = 0; // us, added after the curve
+};
+static_assert(sizeof(MixerInputSettings) == 8);
+
+struct MixLine
+{
+	static constexpr uint8_t unused = 0xFF;
+
+	uint8_t source = unused; // input: `AnalogChannel` or AUX (`mixerCurvedInputsCount` + index)
+	uint8_t target = unused; // output channel
+	int8_t weight = 0; // percent
+
+	constexpr bool valid() const { return source < mixerInputsCount && target < controlChannelsCount; }
+	constexpr bool operator==(const MixLine&) const = default;
+};
+
+/// Common mixes, written into the mix lines. Weights of combined inputs are
+/// halved, so full deflection of both doesn't go out of range (rates can add
+/// the throw back).
+enum class MixPreset : uint8_t
+{
+	None,
+	Elevon,     // Elevator & aileron outputs drive the elevons.
+	VTail,      // Elevator & rudder outputs drive the V-tail surfaces.
+	Flaperon,   // Aileron & channel 5 outputs drive the ailerons, with channel 5 input as flaps.
+	Custom,     // Not a preset, lines don't match any of them.
+};
+
+struct MixerSettings
+{
+	static constexpr uint8_t maxLines = 8;
+
+	MixerInputSettings inputs[mixerCurvedInputsCount];
+	MixLine lines[maxLines];
+
+	constexpr void applyPreset(MixPreset preset)
+	{
+		constexpr auto elevator = static_cast<uint8_t>(AnalogChannel::Elevator);
+		constexpr auto aileron  = static_cast<uint8_t>(AnalogChannel::Aileron);
+		constexpr auto rudder   = static_cast<uint8_t>(AnalogChannel::Rudder);
+		constexpr auto flaps    = static_cast<uint8_t>(AnalogChannel::Channel5);
+		for (auto& line : lines) line = {};
+		switch (preset) {
+			case MixPreset::Elevon:
+				lines[0] = { elevator, elevator,  50 };
+				lines[1] = { aileron,  elevator,  50 };
+				lines[2] = { elevator, aileron,   50 };
+				lines[3] = { aileron,  aileron,  -50 };
+				break;
+			case MixPreset::VTail:
+				lines[0] = { elevator, elevator,  50 };
+				lines[1] = { rudder,   elevator,  50 };
+				lines[2] = { elevator, rudder,    50 };
+				lines[3] = { rudder,   rudder,   -50 };
+				break;
+			case MixPreset::Flaperon:
+				lines[0] = { aileron,  aileron,   50 };
+				lines[1] = { flaps,    aileron,   50 };
+				lines[2] = { aileron,  flaps,    -50 };
+				lines[3] = { flaps,    flaps,     50 };
+				break;
+			default:
+				break;
+		}
+	}
+
+	/// Returns the preset matching current lines, or `MixPreset::Custom`.
+	constexpr MixPreset preset() const
+	{
+		for (uint8_t p = 0; p < static_cast<uint8_t>(MixPreset::Custom); p++) {
+			MixerSettings other;
+			other.applyPreset(static_cast<MixPreset>(p));
+			bool same = true;
+			for (uint8_t i = 0; i < maxLines; i++) same = same && other.lines[i] == lines[i];
+			if (same)
+				return static_cast<MixPreset>(p);
+		}
+		return MixPreset::Custom;
+	}
+};
+static_assert(sizeof(MixerSettings) == 0x40);
+
+/// Reference curve: `rate * ((1 - expo) * x + expo * x^3)`, for `x` being
+/// the deflection relative to the full scale. Slow-ish (64-bit multiply
+/// & divide), used to compile the lookup tables.
+constexpr int16_t applyCurve(int16_t deflection, uint8_t expo, uint8_t rate)
+{
+	constexpr int64_t squaredScale = static_cast<int64_t>(mixerFullScale) * mixerFullScale;
+	constexpr int64_t denominator = 100 * 100 * squaredScale;
+	const int64_t x = deflection;
+	const int64_t numerator = (x * (100 - expo) * squaredScale + expo * x * x * x) * rate;
+	// Rounding half away from zero, keeping the curve symmetric
+	return (numerator + (numerator < 0 ? -denominator : denominator) / 2) / denominator;
+}
+
+/// Curve of single input compiled into lookup table, indexed by the deflection magnitude.
+struct MixerCurveTable
+{
+	static constexpr uint16_t size = mixerMaxDeflection + 1;
+
+	int16_t values[size] = {};
+
+	constexpr void compile(uint8_t expo, uint8_t rate)
+	{
+		for (uint16_t i = 0; i < size; i++) {
+			values[i] = applyCurve(i, expo, rate);
+		}
+	}
+
+	/// Maps the deflection, which must be in range of `mixerMaxDeflection` both ways.
+	constexpr int16_t map(int16_t deflection) const
+	{
+		return deflection < 0 ? -values[-deflection] : values[deflection];
+	}
+};
+
+/// Mixer compiled from the settings: curves recompiled only for the inputs
+/// which expo or rates changed, weights matrix only when the lines changed.
+struct CompiledMixer
+{
+	static constexpr uint8_t weightShift = 10; // weights are fixed-point, 1024 being 100%
+
+	MixerSettings source = {};
+	MixerCurveTable curves[mixerCurvedInputsCount][2];
+	int16_t weights[controlChannelsCount][mixerInputsCount] = {};
+	bool compiled = false;
+
+	/// Recompiles changed parts (curves & the matrix), returns number of them.
+	constexpr uint8_t update(const MixerSettings& settings)
+	{
+		uint8_t changedCount = 0;
+		for (uint8_t i = 0; i < mixerCurvedInputsCount; i++) {
+			const auto& c = settings.inputs[i];
+			auto& s = source.inputs[i];
+			for (uint8_t set = 0; set < 2; set++) {
+				if (compiled && s.expo[set] == c.expo[set] && s.rate[set] == c.rate[set])
+					continue;
+				curves[i][set].compile(c.expo[set], c.rate[set]);
+				changedCount += 1;
+			}
+			s = c; // trim & switch are used directly
+		}
+
+		bool linesChanged = !compiled;
+		for (uint8_t i = 0; i < MixerSettings::maxLines; i++) {
+			linesChanged = linesChanged || !(source.lines[i] == settings.lines[i]);
+			source.lines[i] = settings.lines[i];
+		}
+		if (linesChanged) {
+			compileWeights();
+			changedCount += 1;
+		}
+		compiled = true;
+		return changedCount;
+	}
+
+	/// Mixes mapped inputs (us, `AnalogChannel` order) and switches (bit mask) into the channels (us).
+	constexpr void mix(const uint16_t* mapped, uint8_t switches, uint16_t* channels) const
+	{
+		int16_t inputs[mixerInputsCount];
+		for (uint8_t i = 0; i < mixerCurvedInputsCount; i++) {
+			const auto& s = source.inputs[i];
+			int16_t deflection = static_cast<int32_t>(mapped[i]) - mixerNeutral;
+			if (deflection < -mixerMaxDeflection) deflection = -mixerMaxDeflection;
+			if (deflection >  mixerMaxDeflection) deflection =  mixerMaxDeflection;
+			const uint8_t set = s.rateSwitch >= 0 && (switches & (1 << s.rateSwitch)) ? 1 : 0;
+			inputs[i] = curves[i][set].map(deflection) + s.trim;
+		}
+		for (uint8_t i = 0; i < mixerInputsCount - mixerCurvedInputsCount; i++) {
+			// Switches as 2-position inputs (on is low)
+			inputs[mixerCurvedInputsCount + i] = switches & (1 << i) ? -mixerFullScale : mixerFullScale;
+		}
+
+		for (uint8_t o = 0; o < controlChannelsCount; o++) {
+			int32_t sum = 0;
+			for (uint8_t i = 0; i < mixerInputsCount; i++) {
+				sum += static_cast<int32_t>(weights[o][i]) * inputs[i];
+			}
+			const int32_t us = mixerNeutral + ((sum + (1 << (weightShift - 1))) >> weightShift);
+			channels[o] = us < controlChannelOffset ? controlChannelOffset : us > controlChannelMax ? controlChannelMax : us;
+		}
+	}
+
+private:
+	constexpr void compileWeights()
+	{
+		bool mixed[controlChannelsCount] = {};
+		for (const auto& line : source.lines) {
+			if (line.valid()) mixed[line.target] = true;
+		}
+		for (uint8_t o = 0; o < controlChannelsCount; o++) {
+			for (uint8_t i = 0; i < mixerInputsCount; i++) {
+				weights[o][i] = !mixed[o] && i == o ? 1 << weightShift : 0;
+			}
+		}
+		for (const auto& line : source.lines) {
+			if (!line.valid())
+				continue;
+			const int32_t scaled = line.weight * (1 << weightShift);
+			weights[line.target][line.source] += (scaled + (scaled < 0 ? -50 : 50)) / 100;
+		}
+	}
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "timing_stats.hpp"
+
+/// Stages of the transmitter work, measured separately.
+enum class ProfileStage : uint8_t
+{
+	// Radio task (per control frame)
+	Sample,   // Taking the analog values from the sampler.
+	Map,      // Mapping the values through calibration tables & the mixer.
+	Pack,     // Building & packing the control frame.
+	Write,    // `radio.write`, including waiting for the ACK.
+	Status,   // Reading the status from the ACK payload.
+	Publish,  // Publishing the state for the UI.
+	// UI (per `loop()`)
+	Input,    // Buttons handling.
+	Render,   // Drawing current page into the frame buffer.
+	Flush,    // Handing the frame buffer changes to the display.
+	Count,    // Not a stage, count of all the stages.
+};
+
+/// Per-stage statistics of durations in CPU cycles (cycle counter, cheap
+/// to read). Each stage is written by single task only (the one running it),
+/// so is the reset: UI resets its stages right away, and requests the radio
+/// task to reset its ones (at next frame).
+struct Profiler
+{
+	static constexpr const char* stageNames[] = {
+		"sample", "map", "pack", "write", "status", "publish", "input", "render", "flush",
+	};
+	static_assert(sizeof(stageNames) / sizeof(stageNames[0]) == static_cast<uint8_t>(ProfileStage::Count));
+
+	TimingStats stages[static_cast<uint8_t>(ProfileStage::Count)]; // CPU cycles
+	std::atomic<bool> radioResetRequested = false;
+
+	static inline uint32_t cycles() { return ESP.getCycleCount(); }
+
+	TimingStats& operator[](ProfileStage stage) { return stages[static_cast<uint8_t>(stage)]; }
+
+	/// Resets stages in given range (`last` excluded).
+	void reset(ProfileStage first, ProfileStage last)
+	{
+		for (uint8_t i = static_cast<uint8_t>(first); i < static_cast<uint8_t>(last); i++) stages[i].reset();
+	}
+
+	/// Called by the UI.
+	void requestReset()
+	{
+		reset(ProfileStage::Input, ProfileStage::Count);
+		radioResetRequested = true;
+	}
+
+	/// Called by the radio task, at the frame start.
+	void resetIfRequested()
+	{
+		if (radioResetRequested.exchange(false)) {
+			reset(ProfileStage::Sample, ProfileStage::Input);
+		}
+	}
+
+	/// Writes the statistics as text table (in microseconds).
+	void dump(Print& output)
+	{
+		const float mhz = getCpuFrequencyMhz();
+		output.printf("stage      count    avg[us]    p99[us]    max[us]\n");
+		for (uint8_t i = 0; i < static_cast<uint8_t>(ProfileStage::Count); i++) {
+			const auto& stats = stages[i];
+			output.printf("%-8s %7lu %10.1f %10.1f %10.1f\n", stageNames[i], stats.count,
+				stats.average() / mhz, stats.percentile(99) / mhz, stats.max / mhz);
+		}
+	}
+};
+inline Profiler profiler;
+
+/// Measures consecutive stages: each `end` adds time since the previous one
+/// (or the construction) to given stage of the profiler.
+struct ProfileLap
+{
+	uint32_t last = Profiler::cycles();
+
+	inline void end(ProfileStage stage)
+	{
+		const uint32_t now = Profiler::cycles();
+		profiler[stage].add(now - last);
+		last = now;
+	}
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include <atomic>
+#include "timing_stats.hpp"
+
+/// Part of the settings structure saved as single key.
+struct SettingsRecord
+{
+	const char* key; // NVS key, up to 15 characters
+	uint16_t offset; // in the settings structure
+	uint16_t size;
+};
+
+/// Settings storage in NVS (key-value store on flash, which is journaled
+/// and wear-leveled by itself: entries are appended and replayed on start,
+/// so interrupted write leaves previous value). Each record goes under own
+/// key, and only the changed ones are written, by background task, so the
+/// callers (like UI) don't wait for the flash. Note: flash writes still pause
+/// code running from flash on both cores, but only for single small entry.
+class SettingsStore
+{
+public:
+	static constexpr uint8_t maxRecordsCount = 16;
+	static constexpr uint16_t maxRecordSize = 32;
+	static constexpr UBaseType_t taskPriority = 1;
+	static constexpr uint32_t taskStackSize = 4096;
+	static constexpr uint32_t retryDelay = 1000; // ms, after failed write
+
+	// Statistics, updated by the background task
+	TimingStats writeTime; // us, of single record
+	uint32_t writesCount = 0;
+	uint32_t failedCount = 0;
+	std::atomic<bool> resetRequested = false; // by other task, done by the background task
+
+	/// Loads the records over the settings data (which should hold defaults),
+	/// and starts the background task. Returns false if there were no saved
+	/// settings (or saved with other version), so the data is left as it was.
+	bool begin(const char* name, uint32_t version, void* data, uint16_t dataSize,
+		const SettingsRecord* records, uint8_t recordsCount)
+	{
+		this->data = static_cast<uint8_t*>(data);
+		this->records = records;
+		this->recordsCount = recordsCount < maxRecordsCount ? recordsCount : maxRecordsCount;
+		saved = new uint8_t[dataSize];
+		mutex = xSemaphoreCreateMutex();
+		preferences.begin(name);
+
+		bool loaded = preferences.getUInt(versionKey, 0) == version;
+		if (loaded) {
+			for (uint8_t i = 0; i < this->recordsCount; i++) {
+				const auto& record = records[i];
+				// Missing or mismatching record keeps the default
+				if (preferences.getBytesLength(record.key) == record.size) {
+					preferences.getBytes(record.key, this->data + record.offset, record.size);
+				}
+			}
+		}
+		memcpy(saved, this->data, dataSize);
+		this->version = version;
+		versionPending = !loaded; // written after the records, so interrupted first save isn't taken as complete
+
+		xTaskCreatePinnedToCore(taskEntry, "settings", taskStackSize, this, taskPriority, &task, ARDUINO_RUNNING_CORE);
+		return loaded;
+	}
+
+	/// Queues changed records to be written. Quick, doesn't touch the flash.
+	void save()
+	{
+		queue(false);
+	}
+
+	/// Queues all the records to be written, like after resetting to defaults.
+	void saveAll()
+	{
+		queue(true);
+	}
+
+	/// Statistics reset from other task, done by the background task (waking it up).
+	void requestResetStats()
+	{
+		resetRequested = true;
+		xTaskNotifyGive(task);
+	}
+
+	/// Returns count of records waiting to be written.
+	uint8_t pendingCount() const
+	{
+		return __builtin_popcount(dirty);
+	}
+
+private:
+	static constexpr const char* versionKey = "version";
+
+	Preferences preferences;
+	uint8_t* data = nullptr; // current settings, modified by the user
+	uint8_t* saved = nullptr; // copy as queued for writing (guarded by the mutex)
+	const SettingsRecord* records = nullptr;
+	uint8_t recordsCount = 0;
+	uint16_t dirty = 0; // bit mask of records to write (guarded by the mutex)
+	uint32_t version = 0;
+	bool versionPending = false;
+	SemaphoreHandle_t mutex = nullptr;
+	TaskHandle_t task = nullptr;
+
+	void queue(bool all)
+	{
+		bool any = false;
+		xSemaphoreTake(mutex, portMAX_DELAY);
+		for (uint8_t i = 0; i < recordsCount; i++) {
+			const auto& record = records[i];
+			if (all || memcmp(saved + record.offset, data + record.offset, record.size) != 0) {
+				memcpy(saved + record.offset, data + record.offset, record.size);
+				dirty |= 1 << i;
+				any = true;
+			}
+		}
+		xSemaphoreGive(mutex);
+		if (any) {
+			xTaskNotifyGive(task);
+		}
+	}
+
+	static void taskEntry(void* store)
+	{
+		static_cast<SettingsStore*>(store)->run();
+	}
+
+	void run()
+	{
+		uint8_t buffer[maxRecordSize];
+		while (true) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			if (resetRequested.exchange(false)) {
+				writeTime.reset();
+			}
+			while (true) {
+				// Take next record (as queued), then write it without holding the lock
+				xSemaphoreTake(mutex, portMAX_DELAY);
+				const uint16_t mask = dirty;
+				const uint8_t i = mask ? __builtin_ctz(mask) : 0;
+				const auto& record = records[i];
+				if (mask) {
+					memcpy(buffer, saved + record.offset, record.size);
+					dirty &= ~(1 << i);
+				}
+				xSemaphoreGive(mutex);
+				if (!mask) {
+					if (versionPending && preferences.putUInt(versionKey, version)) {
+						versionPending = false;
+					}
+					break;
+				}
+
+				const uint32_t start = micros();
+				const bool written = preferences.putBytes(record.key, buffer, record.size) == record.size;
+				writeTime.add(micros() - start);
+				if (written) {
+					writesCount += 1;
+				}
+				else {
+					failedCount += 1;
+					xSemaphoreTake(mutex, portMAX_DELAY);
+					dirty |= 1 << i; // retry later, unless queued again already
+					xSemaphoreGive(mutex);
+					vTaskDelay(pdMS_TO_TICKS(retryDelay));
+				}
+			}
+		}
+	}
+};
+inline SettingsStore settingsStore;
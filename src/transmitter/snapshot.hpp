@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+/// Lock-free single-writer/multiple-readers snapshot of a value (sequence lock).
+/// Writer never waits; reader retries the copy if the writer was in the middle
+/// of an update. Meant for small structures shared between the FreeRTOS tasks.
+template <typename T>
+class Snapshot
+{
+	std::atomic<uint32_t> sequence = 0; // odd while writing
+	T data;
+
+public:
+	void store(const T& value)
+	{
+		const uint32_t s = sequence.load(std::memory_order_relaxed);
+		sequence.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		data = value;
+		std::atomic_thread_fence(std::memory_order_release);
+		sequence.store(s + 2, std::memory_order_relaxed);
+	}
+
+	T load() const
+	{
+		T copy;
+		uint32_t before, after;
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			copy = data;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		}
+		while (before != after || (before & 1));
+		return copy;
+	}
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+
+/// Activity on the RF channels, as seen by sweeps of the receive power
+/// detector (`testRPD()`, signal above -64 dBm), one channel after another.
+/// For each channel it keeps count of hits (since reset), level (moving
+/// average of the hit rate, so it follows current activity) and its peak
+/// (held, slowly decaying, so short bursts stay visible). Single writer
+/// (radio task); readers might see values from different sweeps, which is
+/// fine for displaying.
+struct Spectrum
+{
+	static constexpr uint8_t channelsCount = 126; // 2400-2525 MHz
+	static constexpr uint8_t levelShift = 3; // moving average over ~8 sweeps
+	static constexpr uint8_t levelMax = 255; // hit on every sweep
+	static constexpr uint8_t peakDecay = 2; // per sweep, so full peak fades in ~128 sweeps
+	static constexpr uint16_t hitsMax = 0xFFFF; // saturating
+
+	uint16_t hits[channelsCount] = {};
+	uint8_t levels[channelsCount] = {};
+	uint8_t peaks[channelsCount] = {};
+	uint16_t sweepsCount = 0; // complete ones, since reset
+	uint8_t next = 0; // channel to scan
+
+	constexpr void reset()
+	{
+		*this = Spectrum();
+	}
+
+	/// Takes result of next channel scan (channel `next`), moving to the following one.
+	constexpr void add(bool hit)
+	{
+		const uint8_t channel = next;
+		if (hit && hits[channel] < hitsMax) hits[channel] += 1;
+		const int16_t level = levels[channel];
+		levels[channel] = level + (((hit ? levelMax : 0) - level) >> levelShift);
+		const uint8_t decayed = peaks[channel] > peakDecay ? peaks[channel] - peakDecay : 0;
+		peaks[channel] = levels[channel] > decayed ? levels[channel] : decayed;
+
+		if (++next == channelsCount) {
+			next = 0;
+			sweepsCount += 1;
+		}
+	}
+
+	/// Noise around given channel: its hits & the neighbours (as the link takes 1-2 MHz).
+	constexpr uint32_t noise(uint8_t channel) const
+	{
+		uint32_t sum = 2ul * hits[channel];
+		if (channel > 0) sum += hits[channel - 1];
+		if (channel + 1 < channelsCount) sum += hits[channel + 1];
+		return sum;
+	}
+
+	/// Finds the quietest channels in given range (inclusive), at least
+	/// `spacing` apart, quietest first. Returns count of the found ones.
+	constexpr uint8_t quietest(uint8_t* out, uint8_t count, uint8_t first, uint8_t last, uint8_t spacing) const
+	{
+		uint8_t found = 0;
+		while (found < count) {
+			int16_t best = -1;
+			for (uint8_t channel = first; channel <= last && channel < channelsCount; channel++) {
+				bool near = false;
+				for (uint8_t i = 0; i < found; i++) {
+					const uint8_t distance = channel > out[i] ? channel - out[i] : out[i] - channel;
+					if (distance < spacing) near = true;
+				}
+				if (!near && (best < 0 || noise(channel) < noise(best))) best = channel;
+			}
+			if (best < 0) break;
+			out[found++] = best;
+		}
+		return found;
+	}
+
+	/// Hits within the band of channels around given one (`halfWidth` each side).
+	constexpr uint32_t bandHits(uint8_t center, uint8_t halfWidth) const
+	{
+		uint32_t sum = 0;
+		for (int16_t channel = center - halfWidth; channel <= center + halfWidth; channel++) {
+			if (0 <= channel && channel < channelsCount) sum += hits[channel];
+		}
+		return sum;
+	}
+
+	/// Finds the busiest bands (`halfWidth` each side of the centers in given
+	/// range, inclusive), not overlapping, busiest first; quiet ones (without
+	/// hits) are left out. Returns count of the found ones.
+	constexpr uint8_t busiestBands(uint8_t* out, uint8_t count, uint8_t first, uint8_t last, uint8_t halfWidth) const
+	{
+		uint8_t found = 0;
+		while (found < count) {
+			int16_t best = -1;
+			uint32_t bestHits = 0;
+			for (uint8_t center = first; center <= last && center < channelsCount; center++) {
+				bool overlaps = false;
+				for (uint8_t i = 0; i < found; i++) {
+					const uint8_t distance = center > out[i] ? center - out[i] : out[i] - center;
+					if (distance <= 2 * halfWidth) overlaps = true;
+				}
+				const uint32_t sum = bandHits(center, halfWidth);
+				if (!overlaps && sum > bestHits) {
+					best = center;
+					bestHits = sum;
+				}
+			}
+			if (best < 0) break;
+			out[found++] = best;
+		}
+		return found;
+	}
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+/// Fixed-size statistics of measured durations (in any unit, like microseconds
+/// or CPU cycles): min/average/max and histogram with power-of-two buckets,
+/// which allows approximating percentiles. Single writer; readers might see
+/// slightly torn values, which is fine for displaying.
+struct TimingStats
+{
+	static constexpr uint8_t bucketsCount = 24;
+
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t buckets[bucketsCount]; // bucket `i` holds values in range [2^(i-1), 2^i)
+
+	TimingStats() { reset(); }
+
+	void reset()
+	{
+		count = 0;
+		min = UINT32_MAX;
+		max = 0;
+		sum = 0;
+		for (auto& bucket : buckets) bucket = 0;
+	}
+
+	static constexpr uint8_t bucketIndex(uint32_t value)
+	{
+		const uint8_t i = value ? 32 - __builtin_clz(value) : 0;
+		return i < bucketsCount ? i : bucketsCount - 1;
+	}
+
+	/// Returns upper bound of values falling into given bucket.
+	static constexpr uint32_t bucketUpperBound(uint8_t i)
+	{
+		return i ? (1ul << i) - 1 : 0;
+	}
+
+	inline void add(uint32_t value)
+	{
+		count += 1;
+		sum += value;
+		if (value < min) min = value;
+		if (value > max) max = value;
+		buckets[bucketIndex(value)] += 1;
+	}
+
+	uint32_t average() const
+	{
+		return count ? sum / count : 0;
+	}
+
+	/// Returns approximated (rounded up to bucket bound) value below which
+	/// given percent of the samples are, limited by the actual max value.
+	uint32_t percentile(uint8_t percent) const
+	{
+		if (count == 0) return 0;
+		const uint64_t threshold = (static_cast<uint64_t>(count) * percent + 99) / 100;
+		uint64_t accumulated = 0;
+		for (uint8_t i = 0; i < bucketsCount; i++) {
+			accumulated += buckets[i];
+			if (accumulated >= threshold) {
+				const uint32_t bound = bucketUpperBound(i);
+				return bound < max ? bound : max;
+			}
+		}
+		return max;
+	}
+};
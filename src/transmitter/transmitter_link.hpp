@@ -0,0 +1,209 @@
+#pragma once
+#include <stdint.h>
+#include "common/hal.hpp"
+#include "common/packets.hpp"
+#include "common/hopping.hpp"
+#include "common/link_profiles.hpp"
+#include "latency_meter.hpp"
+
+/// Frames statistics while using given link profile.
+struct LinkProfileStats
+{
+	uint32_t sentCount;
+	uint32_t ackedCount;
+	uint8_t lossPercent; // last reported by the receiver
+};
+
+/// Link state of the transmitter, as shown by the UI.
+struct TransmitterLinkState
+{
+	ControlFrame controlFrame; // last sent
+	ReceiverSignal rxSignal; // last status
+	uint32_t lastTxSignalTime; // ms
+	uint32_t lastRxSignalTime; // ms
+	uint32_t sentCount;
+	uint32_t ackedCount;
+	uint8_t linkProfile; // active, index in `linkProfiles`
+	uint8_t linkChannel; // active, see `TransmitterRequest::LinkChannel`
+	LinkProfileStats linkProfileStats[linkProfilesCount];
+};
+
+/// Transmitter side of the link: sends the control frames (hopping along the
+/// sequence numbers), takes the statuses & latency echoes from the ACK payloads,
+/// and switches the link profiles & channels along with the receiver. Shared
+/// by the radio task of the firmware and the link simulation, so both run the
+/// same code. Each frame goes in steps (so the firmware can profile them):
+/// `pack`, `write`, `receive` & `endFrame`. Time comes from `hal`; `Radio` is
+/// `RF24` (or its stand-in, with the same names).
+template <typename Radio>
+struct TransmitterLink
+{
+	static constexpr uint16_t linkSwitchTimeout = 2000; // ms, announcing the profile change before switching without confirmation
+	static constexpr uint16_t linkChannelFallback = 1000; // ms without ACKs, before going back to the default channel (as the receiver does)
+
+	Radio& radio;
+	TransmitterLinkState state {};
+	LatencyMeter latencyMeter;
+	TransmitterSignal txSignal; // packed by `pack`
+	HopSequence hops = hopSequence; // of the active link channel
+
+	TransmitterLink(Radio& radio, uint8_t linkProfile) : radio(radio)
+	{
+		state.linkProfile = linkProfile;
+	}
+
+	/// Packs next control frame: channels & switches as set in `state.controlFrame`,
+	/// with next sequence number & the announcement of the link profile or channel,
+	/// if the selected one differs from the active one (the profile goes first);
+	/// then hops to the channel of the frame. Stamped frames carry the time of
+	/// sampling the controls, for the latency mode.
+	void pack(uint8_t selectedProfile, uint8_t selectedChannel, bool stamped, uint32_t stamp)
+	{
+		now = hal::millis();
+		if (state.linkChannel && now - lastAckTime > linkChannelFallback) {
+			setLinkChannel(0);
+		}
+		auto& frame = state.controlFrame;
+		frame.sequence = (frame.sequence + 1) & controlSequenceMask;
+		frame.request = TransmitterRequest::None;
+		frame.extra = 0;
+
+		// Link profile change: announced until the receiver confirms (or doesn't answer
+		// for a while), then both switch after the last sequence number
+		switchProfile = false;
+		if (selectedProfile != state.linkProfile) {
+			if (!announcingLinkProfile) {
+				announcingLinkProfile = true;
+				linkSwitchStartTime = now;
+			}
+			frame.request = TransmitterRequest::LinkProfile;
+			frame.extra = selectedProfile;
+			const bool confirmed = (state.rxSignal.statusPacket.linkProfile >> 4) == selectedProfile;
+			switchProfile = frame.sequence == controlSequenceMask
+				&& (confirmed || now - linkSwitchStartTime > linkSwitchTimeout);
+			pendingProfile = selectedProfile;
+		}
+		else {
+			announcingLinkProfile = false;
+		}
+
+		// Link channel change: announced until the receiver confirms (in a status sent
+		// since), then both switch after the last sequence number; no timeout, as the link
+		// would be lost then
+		switchChannel = false;
+		if (frame.request == TransmitterRequest::None && selectedChannel != state.linkChannel) {
+			if (!announcingLinkChannel || pendingChannel != selectedChannel) {
+				announcingLinkChannel = true;
+				linkChannelConfirmed = false;
+				pendingChannel = selectedChannel;
+			}
+			frame.request = TransmitterRequest::LinkChannel;
+			frame.extra = selectedChannel;
+			switchChannel = frame.sequence == controlSequenceMask && linkChannelConfirmed;
+		}
+		else if (selectedChannel == state.linkChannel) {
+			announcingLinkChannel = false;
+		}
+
+		this->stamped = stamped;
+		txSignal.packetType = stamped ? PacketType::LatencyControl : PacketType::Control;
+		txSignal.controlPacket.pack(frame);
+		txSignal.stamp = stamp;
+		signalSize = stamped ? latencyControlSignalSize : controlSignalSize;
+#if LINK_FHSS
+		radio.setChannel(hops[frame.sequence]); // hop once per frame, receiver follows by the sequence
+#endif
+	}
+
+	/// Sends the packed frame, returns whether it was acknowledged.
+	bool write()
+	{
+		const uint32_t writeStartTime = hal::micros();
+		acked = radio.write(&txSignal, signalSize);
+		if (stamped) {
+			const uint32_t toReception = writeStartTime - txSignal.stamp + linkProfiles[state.linkProfile].transmitTime(signalSize);
+			latencyMeter.onSent(state.controlFrame.sequence, txSignal.stamp, toReception);
+		}
+		state.lastTxSignalTime = now;
+		state.sentCount += 1;
+		auto& profileStats = state.linkProfileStats[state.linkProfile];
+		profileStats.sentCount += 1;
+		if (acked) {
+			lastAckTime = now;
+			state.ackedCount += 1;
+			profileStats.ackedCount += 1;
+		}
+		return acked;
+	}
+
+	/// Takes the ACK payloads of the sent frame: receiver status comes back
+	/// occasionally, without stopping the stream. Returns whether there was one.
+	bool receive()
+	{
+		if (!acked)
+			return false;
+		bool statusReceived = false;
+		while (radio.available()) {
+			const uint8_t size = radio.getDynamicPayloadSize();
+			ReceiverSignal signal;
+			radio.read(&signal, size < sizeof(signal) ? size : sizeof(signal));
+			if (signal.packetType == PacketType::Status) {
+				state.rxSignal = signal;
+				state.lastRxSignalTime = now;
+				state.linkProfileStats[state.linkProfile].lossPercent = signal.statusPacket.lossPercent;
+				if (announcingLinkChannel && signal.statusPacket.linkChannel == pendingChannel) {
+					linkChannelConfirmed = true;
+				}
+				statusReceived = true;
+			}
+			else if (signal.packetType == PacketType::LatencyEcho) {
+				latencyMeter.onEcho(signal.latencyEchoPacket, hal::micros());
+			}
+		}
+		return statusReceived;
+	}
+
+	/// Ends the frame: switches to the announced link channel or profile, if it's time.
+	/// Returns true if the profile changed, for the caller to set the radio & the frame rate up for it.
+	bool endFrame()
+	{
+		if (switchChannel) {
+			setLinkChannel(pendingChannel);
+		}
+		if (!switchProfile)
+			return false;
+		state.linkProfile = pendingProfile;
+		announcingLinkProfile = false;
+		switchProfile = false;
+		return true;
+	}
+
+private:
+	/// Switches to given link channel: the radio right away, or (with the hopping) the sequence, for next frame.
+	void setLinkChannel(uint8_t channel)
+	{
+		state.linkChannel = channel;
+		switchChannel = false;
+		announcingLinkChannel = false;
+		lastAckTime = now; // the fallback counts from here
+#if LINK_FHSS
+		hops = makeHopSequence(LINK_BIND_SEED, channel);
+#else
+		radio.setChannel(fixedLinkChannel(channel));
+#endif
+	}
+
+	uint32_t now = 0; // ms, of packing the frame
+	bool stamped = false;
+	uint8_t signalSize = controlSignalSize;
+	bool acked = false;
+	bool announcingLinkProfile = false;
+	uint32_t linkSwitchStartTime = 0; // ms
+	bool switchProfile = false; // after this frame
+	uint8_t pendingProfile = 0;
+	uint32_t lastAckTime = 0; // ms
+	bool announcingLinkChannel = false;
+	bool linkChannelConfirmed = false;
+	bool switchChannel = false; // after this frame
+	uint8_t pendingChannel = 0;
+};
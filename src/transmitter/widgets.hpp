@@ -0,0 +1,127 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "glyph_cache.hpp"
+
+/// Retained-mode widgets: page is declared as table of them, and each one
+/// remembers what it has drawn, redrawing only when that changes (at most
+/// once per its interval, for noisy values). Labels are drawn once, after
+/// the page is shown (on cleared screen).
+enum class WidgetType : uint8_t
+{
+	Label,  // Static text, in given font.
+	Field,  // Formatted text, in default font (box cleared before) or from glyph cache (covering the box).
+	Bar,    // Horizontal bar, filled proportionally to the value.
+	Marker, // Rectangle outline, shown while the value is non-zero (like selection).
+};
+
+/// Text formatted by the field, with its color.
+struct WidgetText
+{
+	char text[24];
+	uint16_t color;
+};
+
+struct Widget
+{
+	WidgetType type;
+	int16_t x, y; // text cursor (like `setCursor`), or top left corner of the box (default font, bar & marker)
+	int16_t w = 0, h = 0; // box, cleared or covered on redraw
+	uint16_t color = 0xFFFF; // of label, bar & marker (fields set own)
+	const GFXfont* font = nullptr; // of label, default one if null
+	const char* text = nullptr; // of label
+	void (*format)(WidgetText& out) = nullptr; // of field
+	GlyphCache* (*glyphs)(uint16_t color) = nullptr; // for field, instead of default font
+	int32_t (*value)() = nullptr; // of bar & marker
+	int32_t range = 1; // of bar, value for full width
+	uint16_t interval = 0; // ms, minimal between redraws (0 for every change)
+};
+
+/// Renders current page widgets, keeping their state.
+class WidgetRenderer
+{
+public:
+	static constexpr uint8_t maxWidgetsCount = 32;
+	static constexpr uint16_t background = 0x0000;
+
+	/// Starts showing given widgets, all to be drawn (screen is expected to be cleared).
+	void show(const Widget* widgets, uint8_t count)
+	{
+		this->widgets = widgets;
+		this->count = count < maxWidgetsCount ? count : maxWidgetsCount;
+		for (auto& state : states) state.drawn = false;
+	}
+
+	/// Redraws the widgets which changed.
+	void render(GFXcanvas16& canvas, unsigned long now)
+	{
+		for (uint8_t i = 0; i < count; i++) {
+			const Widget& widget = widgets[i];
+			State& state = states[i];
+			if (state.drawn && widget.interval && now - state.time < widget.interval)
+				continue;
+			switch (widget.type) {
+				case WidgetType::Label: {
+					if (state.drawn)
+						continue;
+					canvas.setFont(widget.font);
+					canvas.setTextColor(widget.color);
+					canvas.setCursor(widget.x, widget.y);
+					canvas.print(widget.text);
+					canvas.setFont();
+					break;
+				}
+				case WidgetType::Field: {
+					WidgetText text {};
+					widget.format(text);
+					if (state.drawn && text.color == state.text.color && strcmp(text.text, state.text.text) == 0)
+						continue;
+					state.text = text;
+					if (widget.glyphs) {
+						widget.glyphs(text.color)->draw(canvas, widget.x, widget.y, widget.w, text.text);
+					}
+					else {
+						canvas.fillRect(widget.x, widget.y, widget.w, widget.h ? widget.h : 8, background);
+						canvas.setTextColor(text.color);
+						canvas.setCursor(widget.x, widget.y);
+						canvas.print(text.text);
+					}
+					break;
+				}
+				case WidgetType::Bar: {
+					const int32_t value = constrain(widget.value(), 0, widget.range);
+					const int16_t filled = value * widget.w / widget.range;
+					if (state.drawn && filled == state.value)
+						continue;
+					state.value = filled;
+					canvas.fillRect(widget.x, widget.y, filled, widget.h, widget.color);
+					canvas.fillRect(widget.x + filled, widget.y, widget.w - filled, widget.h, background);
+					break;
+				}
+				case WidgetType::Marker: {
+					const int32_t shown = widget.value() != 0;
+					if (state.drawn && shown == state.value)
+						continue;
+					state.value = shown;
+					canvas.drawRect(widget.x, widget.y, widget.w, widget.h, shown ? widget.color : background);
+					break;
+				}
+			}
+			state.drawn = true;
+			state.time = now;
+		}
+	}
+
+private:
+	struct State
+	{
+		WidgetText text; // of field
+		int32_t value; // of bar & marker
+		unsigned long time; // ms, of last redraw
+		bool drawn;
+	};
+
+	const Widget* widgets = nullptr;
+	uint8_t count = 0;
+	State states[maxWidgetsCount];
+};
@@ -0,0 +1,32 @@
+#include <unity.h>
+#include "receiver/battery_monitor.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Conversion stays within 0.1% of the exact one.
+void test_conversion()
+{
+	for (uint16_t raw = 0; raw <= BatteryMonitor::adcMax; raw++) {
+		const uint32_t exact = static_cast<uint32_t>(raw) * BatteryMonitor::fullScale / BatteryMonitor::adcMax;
+		TEST_ASSERT_UINT32_WITHIN(15, exact, BatteryMonitor::toMillivolts(raw));
+	}
+}
+
+/// First sample is taken as it is, the average settles on steady input.
+void test_average()
+{
+	BatteryMonitor monitor;
+	monitor.add(512);
+	TEST_ASSERT_EQUAL_UINT16(BatteryMonitor::toMillivolts(512), monitor.millivolts());
+	for (uint16_t i = 0; i < 1000; i++) monitor.add(560);
+	TEST_ASSERT_UINT16_WITHIN(1, BatteryMonitor::toMillivolts(560), monitor.millivolts());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_conversion);
+	RUN_TEST(test_average);
+	return UNITY_END();
+}
@@ -0,0 +1,56 @@
+#include <unity.h>
+#include "transmitter/calibration.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Compiled table gives exactly the same results as the reference mapping, for every possible raw value.
+void checkTableEquivalence(const AnalogChannelCalibrationData& calibration)
+{
+	CalibrationTable table;
+	table.compile(calibration);
+	for (uint16_t raw = 0; raw < analogValuesCount; raw++) {
+		TEST_ASSERT_EQUAL_UINT16(mapAnalogValue(raw, calibration), table.map(raw));
+	}
+	// Values above 12 bits wrap, never reading outside the table
+	TEST_ASSERT_EQUAL_UINT16(table.map(0), table.map(analogValuesCount));
+}
+
+void test_table_equivalence()
+{
+	checkTableEquivalence({ .rawMin =  685, .rawCenter =  685, .rawMax = 1647, .usMin = 1000, .usCenter = 1000, .usMax = 2000 });
+	checkTableEquivalence({ .rawMin =  663, .rawCenter = 1047, .rawMax = 1427, .usMin = 1000, .usCenter = 1500, .usMax = 2000 });
+}
+
+void test_table_reversed()
+{
+	checkTableEquivalence({ .rawMin =  663, .rawCenter = 1047, .rawMax = 1427, .usMin = 2000, .usCenter = 1500, .usMax = 1000 });
+}
+
+void test_table_inverted_raw()
+{
+	checkTableEquivalence({ .rawMin = 3793, .rawCenter = 3207, .rawMax = 2779, .usMin = 1000, .usCenter = 1500, .usMax = 2000 });
+}
+
+void test_table_degenerate()
+{
+	checkTableEquivalence({ .rawMin = 1000, .rawCenter = 2000, .rawMax = 2000, .usMin = 1000, .usCenter = 1500, .usMax = 2000 });
+}
+
+void test_mapping_end_points()
+{
+	constexpr AnalogChannelCalibrationData calibration { .rawMin = 685, .rawCenter = 685, .rawMax = 1647, .usMin = 1000, .usCenter = 1000, .usMax = 2000 };
+	TEST_ASSERT_EQUAL_UINT16(1000, mapAnalogValue(685, calibration));
+	TEST_ASSERT_EQUAL_UINT16(2000, mapAnalogValue(1647, calibration));
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_table_equivalence);
+	RUN_TEST(test_table_reversed);
+	RUN_TEST(test_table_inverted_raw);
+	RUN_TEST(test_table_degenerate);
+	RUN_TEST(test_mapping_end_points);
+	return UNITY_END();
+}
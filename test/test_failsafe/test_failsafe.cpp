@@ -0,0 +1,123 @@
+#include <unity.h>
+#include "receiver/failsafe.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Link at given frame period, frames fed as they arrive (some may be skipped, as lost).
+struct Arrivals
+{
+	Failsafe failsafe;
+	uint32_t time = 5'000; // us, of the last frame (not 0, which means none yet)
+	uint8_t sequence = 0;
+
+	void feed(uint32_t period, uint8_t count = 1, uint8_t advance = 1)
+	{
+		for (uint8_t i = 0; i < count; i++) {
+			time += period * advance;
+			sequence = (sequence + advance) & controlSequenceMask;
+			failsafe.feed(time, sequence);
+		}
+	}
+};
+
+void test_entry_after_missed_frames()
+{
+	Arrivals link;
+	link.feed(10'000, 20);
+	TEST_ASSERT_EQUAL_UINT32(10'000, link.failsafe.framePeriod);
+	TEST_ASSERT_EQUAL_UINT32(10 * 10'000, link.failsafe.timeout);
+	TEST_ASSERT_FALSE(link.failsafe.check(link.time + 99'999));
+	TEST_ASSERT_TRUE(link.failsafe.check(link.time + 100'500));
+	TEST_ASSERT_FALSE(link.failsafe.check(link.time + 101'000)); // already in
+	TEST_ASSERT_EQUAL(1, link.failsafe.entriesCount);
+	TEST_ASSERT_EQUAL_UINT32(100'500, link.failsafe.lastEntrySilence);
+	TEST_ASSERT_EQUAL_UINT16(500, link.failsafe.lastEntryLatency);
+}
+
+void test_entry_respects_min_timeout()
+{
+	Arrivals link;
+	link.failsafe.setMissedFramesCount(1);
+	link.feed(2'000, 20); // 500 Hz
+	TEST_ASSERT_EQUAL_UINT32(Failsafe::minTimeout, link.failsafe.timeout);
+	TEST_ASSERT_FALSE(link.failsafe.check(link.time + Failsafe::minTimeout - 1));
+	TEST_ASSERT_TRUE(link.failsafe.check(link.time + Failsafe::minTimeout));
+}
+
+/// Lost frames (2-4 in a row) don't inflate the estimate, as the interval is divided by the advance.
+void test_gaps_dont_inflate_estimate()
+{
+	Arrivals link;
+	link.feed(10'000, 10);
+	for (uint8_t advance = 2; advance <= 4; advance++) {
+		link.feed(10'000, 10, advance);
+		TEST_ASSERT_EQUAL_UINT32(10'000, link.failsafe.framePeriod);
+	}
+}
+
+/// Intervals spanning more than 4 frames, or longer than `maxFramePeriod`, are outages, not the period.
+void test_long_spans_ignored()
+{
+	Arrivals link;
+	link.feed(10'000, 10);
+	link.feed(15'000, 1, 5); // would be 15 ms per frame
+	TEST_ASSERT_EQUAL_UINT32(10'000, link.failsafe.framePeriod);
+	link.feed(Failsafe::maxFramePeriod + 1'000);
+	TEST_ASSERT_EQUAL_UINT32(10'000, link.failsafe.framePeriod);
+}
+
+void test_entry_and_exit_counted()
+{
+	Arrivals link;
+	link.feed(10'000, 10);
+	const uint32_t lastFrameTime = link.time;
+	TEST_ASSERT_TRUE(link.failsafe.check(lastFrameTime + 100'000));
+	TEST_ASSERT_TRUE(link.failsafe.active);
+	link.feed(10'000, 1, 30);
+	TEST_ASSERT_FALSE(link.failsafe.active);
+	TEST_ASSERT_EQUAL(1, link.failsafe.entriesCount);
+	TEST_ASSERT_EQUAL(1, link.failsafe.exitsCount);
+	TEST_ASSERT_EQUAL_UINT32(link.time, link.failsafe.lastExitTime);
+	TEST_ASSERT_EQUAL_UINT32(300'000, link.failsafe.lastExitSilence);
+	TEST_ASSERT_EQUAL_UINT32(10'000, link.failsafe.framePeriod); // outage not taken as the period
+}
+
+/// First frame ends the initial state (active until then), without counting an exit.
+void test_initial_state_not_counted_as_exit()
+{
+	Failsafe failsafe;
+	TEST_ASSERT_TRUE(failsafe.active);
+	TEST_ASSERT_FALSE(failsafe.check(1'000'000));
+	TEST_ASSERT_FALSE(failsafe.feed(1'000'000, 7));
+	TEST_ASSERT_FALSE(failsafe.active);
+	TEST_ASSERT_EQUAL(0, failsafe.exitsCount);
+	TEST_ASSERT_FALSE(failsafe.framePeriodEstimated); // nothing to measure from yet
+}
+
+/// After the period is set (link profile change), first interval is taken as it is, not averaged.
+void test_estimate_restarts_after_set_frame_period()
+{
+	Arrivals link;
+	link.feed(10'000, 10);
+	link.failsafe.setFramePeriod(4'000);
+	TEST_ASSERT_EQUAL_UINT32(4'000, link.failsafe.framePeriod);
+	TEST_ASSERT_EQUAL_UINT32(10 * 4'000, link.failsafe.timeout);
+	TEST_ASSERT_FALSE(link.failsafe.framePeriodEstimated);
+	link.feed(2'000);
+	TEST_ASSERT_EQUAL_UINT32(2'000, link.failsafe.framePeriod);
+	TEST_ASSERT_TRUE(link.failsafe.framePeriodEstimated);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_entry_after_missed_frames);
+	RUN_TEST(test_entry_respects_min_timeout);
+	RUN_TEST(test_gaps_dont_inflate_estimate);
+	RUN_TEST(test_long_spans_ignored);
+	RUN_TEST(test_entry_and_exit_counted);
+	RUN_TEST(test_initial_state_not_counted_as_exit);
+	RUN_TEST(test_estimate_restarts_after_set_frame_period);
+	return UNITY_END();
+}
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include "common/hopping.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+void test_sequence_seeds()
+{
+	TEST_ASSERT_TRUE(verifyHopSequence(makeHopSequence(0)));
+	TEST_ASSERT_TRUE(verifyHopSequence(makeHopSequence(0xFFFFFFFF)));
+	TEST_ASSERT_TRUE(verifyHopSequence(makeHopSequence(LINK_BIND_SEED)));
+}
+
+/// Sequences avoiding a band keep out of it, for any link channel on the spectrum page.
+void test_sequence_avoiding_band()
+{
+	for (uint8_t avoided = hopChannelMin; avoided <= hopChannelMax; avoided++) {
+		TEST_ASSERT_TRUE(verifyHopSequence(makeHopSequence(LINK_BIND_SEED, avoided), avoided));
+	}
+}
+
+/// Tracker following the link, from the frame (given sequence) received at time 0 on its channel.
+HopTracker makeSyncedTracker(uint8_t sequence)
+{
+	HopTracker tracker;
+	tracker.index = sequence;
+	tracker.onFrame(sequence, 0);
+	return tracker;
+}
+
+/// Frame carrying other hop index is corrupted (despite the CRC), so it's rejected, keeping the hopping.
+void test_tracker_rejects_other_sequence()
+{
+	HopTracker tracker = makeSyncedTracker(5);
+	TEST_ASSERT_FALSE(tracker.onFrame(9, 2'000));
+	TEST_ASSERT_FALSE(tracker.onFrame(5 + hopChannelsCount / 2, 2'000));
+	TEST_ASSERT_EQUAL_UINT8(5, tracker.index);
+	TEST_ASSERT_EQUAL_UINT16(0, tracker.stats[9].receivedCount);
+}
+
+/// Frame of the previous hop (arriving late, after the tracker hopped already) is still taken.
+void test_tracker_accepts_previous_sequence()
+{
+	constexpr uint32_t framePeriod = 10'000;
+	HopTracker tracker = makeSyncedTracker(hopChannelsCount - 1);
+	TEST_ASSERT_TRUE(tracker.update(HopTracker::hopDelay, framePeriod));
+	TEST_ASSERT_EQUAL_UINT8(0, tracker.index); // wrapped
+	TEST_ASSERT_TRUE(tracker.onFrame(hopChannelsCount - 1, HopTracker::hopDelay + 100));
+	TEST_ASSERT_EQUAL_UINT8(hopChannelsCount - 1, tracker.index);
+	TEST_ASSERT_TRUE(tracker.update(tracker.nextHopTime, framePeriod)); // hops on from there
+	TEST_ASSERT_EQUAL_UINT8(0, tracker.index);
+}
+
+void test_tracker_parks_after_missed_frames()
+{
+	constexpr uint32_t framePeriod = 10'000;
+	HopTracker tracker = makeSyncedTracker(0);
+	TEST_ASSERT_TRUE(tracker.update(HopTracker::hopDelay, framePeriod)); // after the received frame
+	for (uint8_t missed = 1; missed < HopTracker::parkAfterMissedCount; missed++) {
+		TEST_ASSERT_TRUE(tracker.update(tracker.nextHopTime, framePeriod));
+		TEST_ASSERT_FALSE(tracker.parked);
+	}
+	const uint8_t index = tracker.index;
+	TEST_ASSERT_FALSE(tracker.update(tracker.nextHopTime, framePeriod)); // stays on the channel
+	TEST_ASSERT_TRUE(tracker.parked);
+	TEST_ASSERT_EQUAL_UINT8(index, tracker.index);
+}
+
+/// Parked tracker meets the transmitter (hopping every frame) within `acquisitionFramesMax`
+/// frames, whatever the hop offset between them.
+void test_tracker_acquires_any_offset()
+{
+	constexpr uint32_t framePeriod = 10'000;
+	for (uint8_t offset = 0; offset < hopChannelsCount; offset++) {
+		HopTracker tracker;
+		uint16_t frame = 0;
+		for (; frame < 2 * HopTracker::acquisitionFramesMax; frame++) {
+			const uint32_t time = frame * framePeriod + framePeriod / 2;
+			const uint8_t sequence = (offset + frame) & (hopChannelsCount - 1);
+			tracker.update(time, framePeriod);
+			if (tracker.channel() == hopSequence[sequence]) {
+				TEST_ASSERT_TRUE(tracker.onFrame(sequence, time));
+				break;
+			}
+		}
+		TEST_ASSERT_LESS_THAN(HopTracker::acquisitionFramesMax, frame);
+		TEST_ASSERT_FALSE(tracker.parked);
+		TEST_ASSERT_EQUAL_UINT16(1, tracker.resyncCount);
+	}
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_sequence_seeds);
+	RUN_TEST(test_sequence_avoiding_band);
+	RUN_TEST(test_tracker_rejects_other_sequence);
+	RUN_TEST(test_tracker_accepts_previous_sequence);
+	RUN_TEST(test_tracker_parks_after_missed_frames);
+	RUN_TEST(test_tracker_acquires_any_offset);
+	return UNITY_END();
+}
@@ -0,0 +1,41 @@
+#include <unity.h>
+#include "transmitter/latency_meter.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Percentiles are rounded up to the bucket bounds, limited by the max.
+void test_histogram()
+{
+	LatencyHistogram histogram;
+	for (uint32_t us = 0; us < 10'000; us += 100) histogram.add(us); // 100 samples
+	histogram.add(80'000); // overflow, to the last bucket
+	TEST_ASSERT_EQUAL_UINT32(101, histogram.count);
+	TEST_ASSERT_EQUAL_UINT32(5249, histogram.percentile(50));
+	TEST_ASSERT_EQUAL_UINT32(9999, histogram.percentile(99));
+	TEST_ASSERT_EQUAL_UINT32(80'000, histogram.percentile(100));
+	TEST_ASSERT_EQUAL(1, histogram.buckets[LatencyHistogram::bucketsCount - 1]);
+}
+
+/// Echo adds both measures, stale one (sequence reused) is rejected.
+void test_echo()
+{
+	LatencyMeter meter;
+	meter.onSent(3, 1000, 1500);
+	meter.onSent(35, 0xFFFF'FF00, 700); // same slot as 3, after wrapping, with time wrapping too
+	LatencyEchoPacket echo { .stamp = 1000, .latchDelay = 12'000, .sequence = 3 };
+	TEST_ASSERT_FALSE(meter.onEcho(echo, 30'000));
+	TEST_ASSERT_EQUAL(1, meter.unmatchedCount);
+	echo.stamp = 0xFFFF'FF00;
+	TEST_ASSERT_TRUE(meter.onEcho(echo, 20'000));
+	TEST_ASSERT_EQUAL_UINT32(20'256, meter.roundTrip.max);
+	TEST_ASSERT_EQUAL_UINT32(12'700, meter.oneWay.max);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_histogram);
+	RUN_TEST(test_echo);
+	return UNITY_END();
+}
@@ -0,0 +1,52 @@
+#include <unity.h>
+#include "receiver/latency_probe.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+void test_nothing_followed()
+{
+	LatencyProbe probe;
+	LatencyEchoPacket echo {};
+	uint32_t receptionTime = 0;
+	probe.onLatch(1000);
+	TEST_ASSERT_FALSE(probe.takeEcho(echo, receptionTime));
+}
+
+/// First frame since the latch is echoed (once), with the delay from its reception.
+void test_first_frame_echoed()
+{
+	LatencyProbe probe;
+	LatencyEchoPacket echo {};
+	uint32_t receptionTime = 0;
+	probe.onOutputs(111, 1, 2000);
+	probe.onOutputs(222, 2, 4000); // same latch, not followed
+	probe.onLatch(20'000);
+	TEST_ASSERT_TRUE(probe.takeEcho(echo, receptionTime));
+	TEST_ASSERT_EQUAL_UINT32(111, echo.stamp);
+	TEST_ASSERT_EQUAL_UINT8(1, echo.sequence);
+	TEST_ASSERT_EQUAL_UINT16(18'000, echo.latchDelay);
+	TEST_ASSERT_EQUAL_UINT32(2000, receptionTime);
+	TEST_ASSERT_FALSE(probe.takeEcho(echo, receptionTime));
+}
+
+void test_delay_saturated()
+{
+	LatencyProbe probe;
+	LatencyEchoPacket echo {};
+	uint32_t receptionTime = 0;
+	probe.onOutputs(333, 3, 0xFFFF'FFF0); // time wraps
+	probe.onLatch(100'000);
+	TEST_ASSERT_TRUE(probe.takeEcho(echo, receptionTime));
+	TEST_ASSERT_EQUAL_UINT32(333, echo.stamp);
+	TEST_ASSERT_EQUAL_UINT16(LatencyProbe::maxLatchDelay, echo.latchDelay);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_nothing_followed);
+	RUN_TEST(test_first_frame_echoed);
+	RUN_TEST(test_delay_saturated);
+	return UNITY_END();
+}
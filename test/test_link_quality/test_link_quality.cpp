@@ -0,0 +1,55 @@
+#include <unity.h>
+#include "receiver/link_quality.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Feeds frames at 10 ms period (with 100 us jitter), losing given ones.
+LinkQuality feedFrames(uint16_t framesCount, uint16_t lostFrom, uint16_t lostTo)
+{
+	LinkQuality quality;
+	for (uint16_t i = 0; i < framesCount; i++) {
+		if (lostFrom <= i && i < lostTo)
+			continue;
+		quality.onFrame(i, i * 10'000ul + (i % 2) * 100, true);
+	}
+	return quality;
+}
+
+void checkJitter(const LinkQuality& quality)
+{
+	TEST_ASSERT_UINT16_WITHIN(75, 125, quality.jitter());
+}
+
+void test_no_loss()
+{
+	const LinkQuality quality = feedFrames(200, 0, 0);
+	TEST_ASSERT_EQUAL_UINT8(0, quality.lossPercent());
+	TEST_ASSERT_EQUAL_UINT8(0, quality.longestGap());
+	checkJitter(quality);
+}
+
+void test_gap()
+{
+	const LinkQuality quality = feedFrames(200, 150, 163); // 13 of 128 lost
+	TEST_ASSERT_EQUAL_UINT8(10, quality.lossPercent());
+	TEST_ASSERT_EQUAL_UINT8(13, quality.longestGap());
+	checkJitter(quality);
+}
+
+void test_gap_longer_than_sequence_wrap()
+{
+	const LinkQuality quality = feedFrames(300, 200, 250);
+	TEST_ASSERT_EQUAL_UINT8(39, quality.lossPercent());
+	TEST_ASSERT_EQUAL_UINT8(50, quality.longestGap());
+	checkJitter(quality);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_no_loss);
+	RUN_TEST(test_gap);
+	RUN_TEST(test_gap_longer_than_sequence_wrap);
+	return UNITY_END();
+}
@@ -0,0 +1,91 @@
+#include <unity.h>
+#include "transmitter/mixer.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Compiled curve gives exactly the same results as the reference one.
+void checkCurveTable(uint8_t expo, uint8_t rate)
+{
+	MixerCurveTable table;
+	table.compile(expo, rate);
+	for (int16_t deflection = -mixerMaxDeflection; deflection <= mixerMaxDeflection; deflection++) {
+		TEST_ASSERT_EQUAL_INT16(applyCurve(deflection, expo, rate), table.map(deflection));
+	}
+}
+
+/// Mixes single set of inputs (sticks at given deflections, switches) with given settings.
+uint16_t mixChannel(const MixerSettings& settings, const int16_t deflection[mixerCurvedInputsCount],
+	uint8_t switches, uint8_t channel)
+{
+	CompiledMixer mixer;
+	mixer.update(settings);
+	uint16_t mapped[mixerCurvedInputsCount] = {};
+	for (uint8_t i = 0; i < mixerCurvedInputsCount; i++) mapped[i] = mixerNeutral + deflection[i];
+	uint16_t channels[controlChannelsCount] = {};
+	mixer.mix(mapped, switches, channels);
+	return channels[channel];
+}
+
+void test_curve_tables()
+{
+	checkCurveTable(0, 100);
+	checkCurveTable(35, 100);
+	checkCurveTable(100, 125);
+	checkCurveTable(60, 70);
+}
+
+void test_curve()
+{
+	TEST_ASSERT_EQUAL_INT16(mixerFullScale, applyCurve(mixerFullScale, 40, 100)); // expo keeps the end points
+	TEST_ASSERT_EQUAL_INT16(-63, applyCurve(-250, 100, 100));
+}
+
+/// Default settings pass the inputs (in the limits) and the switches as before the mixer.
+void test_identity()
+{
+	MixerSettings settings;
+	CompiledMixer mixer;
+	mixer.update(settings);
+	for (uint16_t us = mixerNeutral - mixerMaxDeflection; us <= mixerNeutral + mixerMaxDeflection; us += 7) {
+		const uint16_t mapped[mixerCurvedInputsCount] = { us, us, us, us, us };
+		uint16_t channels[controlChannelsCount] = {};
+		mixer.mix(mapped, 0b101, channels);
+		for (uint8_t i = 0; i < mixerCurvedInputsCount; i++) {
+			TEST_ASSERT_EQUAL_UINT16(us, channels[i]);
+		}
+		TEST_ASSERT_EQUAL_UINT16(1000, channels[5]);
+		TEST_ASSERT_EQUAL_UINT16(2000, channels[6]);
+		TEST_ASSERT_EQUAL_UINT16(1000, channels[7]);
+	}
+	TEST_ASSERT_EQUAL(0, mixer.update(settings)); // nothing to recompile
+}
+
+void test_elevon_and_rates()
+{
+	constexpr auto elevator = static_cast<uint8_t>(AnalogChannel::Elevator);
+	constexpr auto aileron  = static_cast<uint8_t>(AnalogChannel::Aileron);
+	MixerSettings settings;
+	settings.applyPreset(MixPreset::Elevon);
+	TEST_ASSERT_TRUE(settings.preset() == MixPreset::Elevon);
+	auto& input = settings.inputs[aileron];
+	input.rate[1] = 50;
+	input.rateSwitch = 1;
+	input.trim = 10;
+	const int16_t deflection[mixerCurvedInputsCount] = { 0, 0, 200, 400, 0 };
+	// Elevator 200, aileron 400 + 10 trim (or half rate: 200 + 10)
+	TEST_ASSERT_EQUAL_UINT16(1500 + 100 + 205, mixChannel(settings, deflection, 0b000, elevator));
+	TEST_ASSERT_EQUAL_UINT16(1500 + 100 - 205, mixChannel(settings, deflection, 0b000, aileron));
+	TEST_ASSERT_EQUAL_UINT16(1500 + 100 + 105, mixChannel(settings, deflection, 0b010, elevator));
+	TEST_ASSERT_EQUAL_UINT16(1500 + 100 - 105, mixChannel(settings, deflection, 0b010, aileron));
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_curve_tables);
+	RUN_TEST(test_curve);
+	RUN_TEST(test_identity);
+	RUN_TEST(test_elevon_and_rates);
+	return UNITY_END();
+}
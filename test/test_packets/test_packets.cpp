@@ -0,0 +1,60 @@
+#include <unity.h>
+#include "common/packets.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+ControlFrame makeFrame(uint16_t first, uint16_t step, uint8_t sequence, uint8_t switches)
+{
+	ControlFrame frame;
+	frame.request = TransmitterRequest::Status;
+	frame.sequence = sequence;
+	for (uint8_t i = 0; i < controlChannelsCount; i++)
+		frame.channels[i] = first + i * step;
+	frame.switches = switches;
+	frame.extra = sequence ^ switches;
+	return frame;
+}
+
+/// Packs & unpacks the frame, expecting the channels clamped to the packed range.
+void checkRoundTrip(const ControlFrame& frame)
+{
+	ControlPacket packet {};
+	packet.pack(frame);
+	const ControlFrame unpacked = packet.unpack();
+	TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(frame.request), static_cast<uint8_t>(unpacked.request));
+	TEST_ASSERT_EQUAL_UINT8(frame.sequence & controlSequenceMask, unpacked.sequence);
+	TEST_ASSERT_EQUAL_UINT8(frame.switches, unpacked.switches);
+	TEST_ASSERT_EQUAL_UINT8(frame.extra, unpacked.extra);
+	for (uint8_t i = 0; i < controlChannelsCount; i++) {
+		const uint16_t expected = frame.channels[i] < controlChannelOffset ? controlChannelOffset
+			: frame.channels[i] > controlChannelMax ? controlChannelMax : frame.channels[i];
+		TEST_ASSERT_EQUAL_UINT16(expected, unpacked.channels[i]);
+	}
+}
+
+void test_round_trip()
+{
+	checkRoundTrip(makeFrame(1000, 137, 0, 0b000));
+	checkRoundTrip(makeFrame(controlChannelOffset, 0, 31, 0b111));
+	checkRoundTrip(makeFrame(controlChannelMax, 0, 17, 0b101));
+}
+
+void test_round_trip_sequence_wraps()
+{
+	checkRoundTrip(makeFrame(700, 229, 42, 0xFF));
+}
+
+void test_round_trip_clamped()
+{
+	checkRoundTrip(makeFrame(0, 400, 5, 0b010));
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_round_trip);
+	RUN_TEST(test_round_trip_sequence_wraps);
+	RUN_TEST(test_round_trip_clamped);
+	return UNITY_END();
+}
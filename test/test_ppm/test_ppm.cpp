@@ -0,0 +1,52 @@
+#include <unity.h>
+#include "receiver/ppm.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Goes through two frames (changing the channels in the middle of first one),
+/// checking the frame length and that the change applies from the next frame.
+void checkEncoder(uint16_t first, uint16_t step)
+{
+	uint16_t channels[PpmEncoder::channelsCount] = {};
+	for (uint8_t i = 0; i < PpmEncoder::channelsCount; i++) channels[i] = 1500;
+	PpmEncoder encoder;
+	for (uint8_t frame = 0; frame < 2; frame++) {
+		uint32_t total = 0;
+		for (uint8_t i = 0; i <= PpmEncoder::channelsCount; i++) {
+			const uint16_t length = encoder.next(channels);
+			if (i < PpmEncoder::channelsCount) {
+				const uint16_t expected = frame == 0 ? 1500 : first + i * step;
+				const uint16_t clamped = expected < PpmEncoder::minChannel ? PpmEncoder::minChannel
+					: expected > PpmEncoder::maxChannel ? PpmEncoder::maxChannel : expected;
+				TEST_ASSERT_EQUAL_UINT16(clamped, length);
+			}
+			else {
+				TEST_ASSERT_GREATER_OR_EQUAL_UINT16(PpmEncoder::minSyncLength, length);
+			}
+			total += length;
+			if (frame == 0 && i == 3) {
+				for (uint8_t c = 0; c < PpmEncoder::channelsCount; c++) channels[c] = first + c * step;
+			}
+		}
+		TEST_ASSERT_EQUAL_UINT32(PpmEncoder::frameLength, total);
+	}
+}
+
+void test_encoder()
+{
+	checkEncoder(1000, 125);
+}
+
+void test_encoder_clamped()
+{
+	checkEncoder(500, 300);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_encoder);
+	RUN_TEST(test_encoder_clamped);
+	return UNITY_END();
+}
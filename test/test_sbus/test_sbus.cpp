@@ -0,0 +1,47 @@
+#include <unity.h>
+#include "receiver/sbus.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Packs 8 channels (others go neutral), checks the framing & the decoded widths (within 1 us).
+void checkFrame(uint16_t first, uint16_t step, uint8_t flags)
+{
+	uint16_t channels[8] = {};
+	for (uint8_t i = 0; i < 8; i++) channels[i] = first + i * step;
+	SbusFrame frame;
+	frame.pack(channels, 8, flags);
+	TEST_ASSERT_EQUAL_HEX8(SbusFrame::header, frame.bytes[0]);
+	TEST_ASSERT_EQUAL_HEX8(flags, frame.bytes[23]);
+	TEST_ASSERT_EQUAL_HEX8(SbusFrame::footer, frame.bytes[24]);
+	for (uint8_t i = 0; i < SbusFrame::channelsCount; i++) {
+		const uint16_t us = i < 8 ? channels[i] : 1500;
+		TEST_ASSERT_UINT16_WITHIN(1, us, SbusFrame::toMicroseconds(frame.channel(i)));
+	}
+}
+
+void test_microseconds_conversion()
+{
+	TEST_ASSERT_EQUAL_UINT16(192, SbusFrame::fromMicroseconds(1000));
+	TEST_ASSERT_EQUAL_UINT16(992, SbusFrame::fromMicroseconds(1500));
+	TEST_ASSERT_EQUAL_UINT16(1792, SbusFrame::fromMicroseconds(2000));
+}
+
+void test_frame()
+{
+	checkFrame(1000, 125, 0);
+}
+
+void test_frame_flags()
+{
+	checkFrame(900, 170, SbusFrame::frameLost | SbusFrame::failsafe);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_microseconds_conversion);
+	RUN_TEST(test_frame);
+	RUN_TEST(test_frame_flags);
+	return UNITY_END();
+}
@@ -0,0 +1,30 @@
+#include <unity.h>
+#include "receiver/servo_outputs.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Pending widths are clamped and become active only all together, on latch.
+void test_latch()
+{
+	ServoOutputs outputs;
+	for (uint8_t i = 0; i < ServoOutputs::count; i++) outputs.set(i, 1500);
+	outputs.latch();
+	outputs.set(0, 100);
+	outputs.set(1, 3000);
+	TEST_ASSERT_EQUAL_UINT16(1500, outputs.active[0]);
+	TEST_ASSERT_EQUAL_UINT16(1500, outputs.active[1]);
+	outputs.latch();
+	outputs.latch(); // nothing new
+	TEST_ASSERT_EQUAL_UINT16(ServoOutputs::minPulse, outputs.active[0]);
+	TEST_ASSERT_EQUAL_UINT16(ServoOutputs::maxPulse, outputs.active[1]);
+	TEST_ASSERT_EQUAL_UINT16(1500, outputs.active[2]);
+	TEST_ASSERT_EQUAL(2, outputs.latchedCount);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_latch);
+	return UNITY_END();
+}
@@ -0,0 +1,58 @@
+#include <unity.h>
+#include "transmitter/spectrum.hpp"
+
+void setUp() {}
+void tearDown() {}
+
+/// Channels 10-12 busy for 20 sweeps, then quiet; others have rare hits, except 15, 20 & 30.
+Spectrum makeSpectrum()
+{
+	Spectrum spectrum;
+	for (uint8_t sweep = 0; sweep < 40; sweep++) {
+		for (uint8_t channel = 0; channel < Spectrum::channelsCount; channel++) {
+			const bool busy = sweep < 20 && 10 <= channel && channel <= 12;
+			const bool noisy = channel != 15 && channel != 20 && channel != 30;
+			spectrum.add(busy || (noisy && sweep % 10 == 0));
+		}
+	}
+	return spectrum;
+}
+
+/// Busy channel rises & keeps the peak after going quiet.
+void test_levels_and_peaks()
+{
+	const Spectrum spectrum = makeSpectrum();
+	TEST_ASSERT_EQUAL(40, spectrum.sweepsCount);
+	TEST_ASSERT_LESS_OR_EQUAL(spectrum.peaks[11] / 4, spectrum.levels[11]);
+	TEST_ASSERT_GREATER_OR_EQUAL(150, spectrum.peaks[11]);
+}
+
+/// Quietest channels avoid the busy one (and its neighbours), keeping the spacing.
+void test_quietest()
+{
+	const Spectrum spectrum = makeSpectrum();
+	uint8_t quiet[3] = {};
+	TEST_ASSERT_EQUAL_UINT8(3, spectrum.quietest(quiet, 3, 2, 40, 5));
+	TEST_ASSERT_EQUAL_UINT8(15, quiet[0]);
+	TEST_ASSERT_EQUAL_UINT8(20, quiet[1]);
+	TEST_ASSERT_EQUAL_UINT8(30, quiet[2]);
+}
+
+/// Busiest band covers the busy channels, next one doesn't overlap it.
+void test_busiest_bands()
+{
+	const Spectrum spectrum = makeSpectrum();
+	uint8_t busy[2] = {};
+	TEST_ASSERT_EQUAL_UINT8(2, spectrum.busiestBands(busy, 2, 2, 40, 3));
+	TEST_ASSERT_UINT8_WITHIN(2, 11, busy[0]);
+	TEST_ASSERT_GREATER_THAN(6, busy[1] > busy[0] ? busy[1] - busy[0] : busy[0] - busy[1]);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_levels_and_peaks);
+	RUN_TEST(test_quietest);
+	RUN_TEST(test_busiest_bands);
+	return UNITY_END();
+}
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Decodes binary telemetry stream of the receiver (see `src/common/telemetry.hpp`)
+into CSV, one file/stream per record type.
+
+Usage:
+	telemetry_decode.py capture.bin > frames.csv
+	telemetry_decode.py /dev/ttyUSB0 --baud 115200 > frames.csv   (requires pyserial)
+	telemetry_decode.py /dev/ttyUSB0 --decimation 10              (sends the setting first)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_LENGTH = 124 # records must fit the receiver buffer
+
+# type: (name, struct format, columns)
+RECORDS = {
+	1: ('frame', '<IBB8HBBHH', [
+		'time_us', 'sequence', 'switches',
+		'ch1', 'ch2', 'ch3', 'ch4', 'ch5', 'ch6', 'ch7', 'ch8',
+		'signal_rating', 'good_signal', 'link_profile', 'battery_mv', 'dropped_count',
+	]),
+	2: ('failsafe', '<IBIHH', [
+		'time_us', 'entered', 'silence_us', 'latency_us', 'entries_count',
+	]),
+	3: ('hop', '<BBHHH', [
+		'index', 'channel', 'received_count', 'lost_count', 'resync_count',
+	]),
+	4: ('output', '<IHHHH', [
+		'time_us', 'edges_count', 'avg_lateness_half_us', 'max_lateness_half_us', 'latched_count',
+	]),
+	5: ('latency', '<IIHB', [
+		'time_us', 'stamp_us', 'latch_delay_us', 'sequence',
+	]),
+}
+
+def crc8(data, crc=0):
+	for byte in data:
+		crc ^= byte
+		for _ in range(8):
+			crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+	return crc
+
+assert crc8(b'123456789') == 0xF4
+
+def decode(chunks):
+	"""Yields (type, values) of valid records, skipping garbage and corrupted ones."""
+	buffer = bytearray()
+	for chunk in chunks:
+		buffer += chunk
+		while True:
+			start = buffer.find(SYNC)
+			if start < 0:
+				buffer.clear()
+				break
+			del buffer[:start]
+			if len(buffer) < 3:
+				break
+			record_type, length = buffer[1], buffer[2]
+			if length > MAX_LENGTH:
+				del buffer[:1] # false sync
+				continue
+			if len(buffer) < 4 + length:
+				break
+			payload = bytes(buffer[3:3 + length])
+			if crc8(buffer[1:3 + length]) != buffer[3 + length]:
+				del buffer[:1] # false sync, search again
+				continue
+			del buffer[:4 + length]
+			record = RECORDS.get(record_type)
+			if record is None or struct.calcsize(record[1]) != length:
+				yield record_type, None
+				continue
+			values = list(struct.unpack(record[1], payload))
+			if record_type == 1:
+				flags = values[12] # bit fields
+				values[12:13] = [flags & 1, (flags >> 1) & 0x0F]
+			yield record_type, values
+
+def read_file(path):
+	with open(path, 'rb') as f:
+		while chunk := f.read(4096):
+			yield chunk
+
+def read_serial(port, baud, decimation):
+	import serial # pyserial
+	with serial.Serial(port, baud, timeout=0.1) as s:
+		if decimation is not None:
+			s.write(f'd{decimation}\n'.encode())
+		while True:
+			yield s.read(256)
+
+def main():
+	parser = argparse.ArgumentParser(description='Decodes receiver telemetry into CSV.')
+	parser.add_argument('source', help='captured binary file or serial port')
+	parser.add_argument('--baud', type=int, default=115200)
+	parser.add_argument('--decimation', type=int, help='sets frame records decimation on the receiver (serial port only)')
+	parser.add_argument('--type', default='frame', choices=[r[0] for r in RECORDS.values()], help='record type to output')
+	args = parser.parse_args()
+
+	if args.source.startswith('/dev/') or args.source.upper().startswith('COM'):
+		chunks = read_serial(args.source, args.baud, args.decimation)
+	else:
+		chunks = read_file(args.source)
+
+	wanted = next(t for t, r in RECORDS.items() if r[0] == args.type)
+	writer = csv.writer(sys.stdout, lineterminator='\n')
+	writer.writerow(RECORDS[wanted][2])
+	unknown = 0
+	try:
+		for record_type, values in decode(chunks):
+			if values is None:
+				unknown += 1
+			elif record_type == wanted:
+				writer.writerow(values)
+	except KeyboardInterrupt:
+		pass
+	if unknown:
+		print(f'Skipped {unknown} records of unknown type/size', file=sys.stderr)
+
+if __name__ == '__main__':
+	main()